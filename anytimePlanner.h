@@ -0,0 +1,443 @@
+//  anytimePlanner.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Anytime Repairing A*: a first coffee route at once, improved until the deadline.
+
+#ifndef anytimePlanner_h
+#define anytimePlanner_h
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "floorGenerator.h"
+#include "floorGraph.h"
+#include "heuristicSearch.h"
+#include "searchLimit.h"
+#include "weightedSearch.h"
+
+// states are the same as in AStarPlanner: v, or v + V once coffee is carried
+// each round is a weighted A* with keys g + epsilon * h, so its route costs at
+// most epsilon times the best; epsilon then shrinks towards 1 and the next round
+// reuses every g value found so far, re-expanding only the states whose g
+// dropped after they were closed (the INCONS list)
+// the best route so far is published under a lock with its bound,
+// min(epsilon, length / lowest g + h still open), so another thread may read it
+// while a round is running
+// g, h, parent, closed and inconsistent hold a state's values only when seen[state]
+// is the query's generation, so begin() does not clear 2V entries of each
+
+class AnytimePlanner
+{
+    private: // data elements
+        const FloorGraph * graph;
+        const Heuristic * heuristic;
+        std::vector<int> coffee;
+        std::vector<int> g;
+        std::vector<int> h;
+        std::vector<int> parent;
+        std::vector<int> closed;
+        std::vector<char> inconsistent;
+        std::vector<uint32_t> seen;
+        uint32_t generation;
+        std::vector<int> incons;
+        std::vector<std::pair<long long, int>> open;
+        int target;
+        int epsilon;
+        int step;
+        int round;
+        int expanded;
+        bool done;
+
+    private: // published route
+        mutable std::mutex lock;
+        std::vector<int> bestRoute;
+        int bestLength;
+        double bestBound;
+
+    public:
+        static constexpr int SCALE = 100;
+
+    public:
+        AnytimePlanner(const FloorGraph &, const Heuristic &);
+
+    public: // accessors
+        bool hasRoute() const;
+        bool isDone() const;
+        double getEpsilon() const;
+        int getExpandedCount() const;
+        int getBest(std::vector<int> &, double &) const;
+
+    public: // queries
+        bool begin(int, int, double, double);
+        bool improve(std::chrono::steady_clock::time_point);
+        bool improve(SearchLimit &);
+        int coffeeRoute(int, int, std::vector<int> &, std::chrono::steady_clock::time_point);
+        SearchResult coffeeRoute(int, int, std::vector<int> &, SearchLimit &);
+
+    private:
+        int estimate(int) const;
+        long long key(int) const;
+        void touch(int);
+        void pushOpen(int);
+        bool improvePath(SearchLimit &);
+        void publish();
+        void reopen(int);
+};
+
+AnytimePlanner::AnytimePlanner(const FloorGraph & graphRef, const Heuristic & heuristicRef)
+{
+    this -> graph = & graphRef;
+    this -> heuristic = & heuristicRef;
+    this -> coffee = graphRef.getCoffeeIds();
+    this -> target = -1;
+    this -> epsilon = SCALE;
+    this -> step = SCALE;
+    this -> round = 0;
+    this -> expanded = 0;
+    this -> done = true;
+    this -> bestLength = -1;
+    this -> bestBound = 0.0;
+    this -> generation = 0;
+    int states = 2 * graphRef.getVertexCount();
+    this -> g.resize(states);
+    this -> h.resize(states);
+    this -> parent.resize(states);
+    this -> closed.resize(states);
+    this -> inconsistent.resize(states);
+    this -> seen.resize(states, 0);
+}
+
+bool AnytimePlanner::hasRoute() const
+{
+    std::lock_guard<std::mutex> guard(this -> lock);
+    return this -> bestLength >= 0;
+}
+
+bool AnytimePlanner::isDone() const
+{
+    return this -> done;
+}
+
+double AnytimePlanner::getEpsilon() const
+{
+    return (double) this -> epsilon / SCALE;
+}
+
+int AnytimePlanner::getExpandedCount() const
+{
+    return this -> expanded;
+}
+
+// the best route so far and its suboptimality bound (1 once it is proven optimal)
+// returns its length, or -1 if no route has been found yet
+
+int AnytimePlanner::getBest(std::vector<int> & route, double & bound) const
+{
+    std::lock_guard<std::mutex> guard(this -> lock);
+    route = this -> bestRoute;
+    bound = this -> bestBound;
+    return this -> bestLength;
+}
+
+// same estimate as AStarPlanner: before the coffee, the cheapest detour through a station
+
+int AnytimePlanner::estimate(int state) const
+{
+    int vCount = this -> graph -> getVertexCount();
+    int goal = this -> target - vCount;
+    if (state >= vCount)
+        return this -> heuristic -> bound(state - vCount, goal);
+    int best = Heuristic::UNREACHABLE;
+    for (size_t i = 0; i < this -> coffee.size(); i++)
+    {
+        int b = this -> heuristic -> bound(state, this -> coffee[i]);
+        if (b < Heuristic::UNREACHABLE)
+            b += this -> heuristic -> bound(this -> coffee[i], goal);
+        best = std::min(best, b);
+    }
+    return best;
+}
+
+long long AnytimePlanner::key(int state) const
+{
+    return (long long) SCALE * this -> g[state] + (long long) this -> epsilon * this -> h[state];
+}
+
+// a stale state is reset when the query first reaches it
+
+void AnytimePlanner::touch(int state)
+{
+    if (this -> seen[state] != this -> generation)
+    {
+        this -> seen[state] = this -> generation;
+        this -> g[state] = -1;
+        this -> h[state] = -1;
+        this -> parent[state] = -1;
+        this -> closed[state] = 0;
+        this -> inconsistent[state] = 0;
+    }
+}
+
+// a min-heap of (key, state); entries left behind when a key drops are skipped on pop
+
+void AnytimePlanner::pushOpen(int state)
+{
+    this -> open.push_back(std::make_pair(key(state), state));
+    std::push_heap(this -> open.begin(), this -> open.end(), std::greater<std::pair<long long, int>>());
+}
+
+// start a new query; epsilon starts at initial and drops by decrement each round
+// returns false for bad ids or when the heuristic proves there is no route
+
+bool AnytimePlanner::begin(int start, int goal, double initial, double decrement)
+{
+    int vCount = this -> graph -> getVertexCount();
+    {
+        std::lock_guard<std::mutex> guard(this -> lock);
+        this -> bestRoute.clear();
+        this -> bestLength = -1;
+        this -> bestBound = 0.0;
+    }
+    this -> done = true;
+    this -> expanded = 0;
+    this -> open.clear();
+    this -> incons.clear();
+    if (start < 0 || start >= vCount || goal < 0 || goal >= vCount)
+        return false;
+
+    this -> target = goal + vCount;
+    this -> epsilon = std::max(SCALE, (int) (initial * SCALE + 0.5));
+    this -> step = std::max(1, (int) (decrement * SCALE + 0.5));
+    this -> round = 1;
+    this -> generation++;
+    if (this -> generation == 0)
+    {
+        std::fill(this -> seen.begin(), this -> seen.end(), 0);
+        this -> generation = 1;
+    }
+
+    int source = start + (this -> graph -> getVertex(start).getC() ? vCount : 0);
+    touch(source);
+    touch(this -> target);
+    this -> g[source] = 0;
+    this -> h[source] = estimate(source);
+    if (this -> h[source] >= Heuristic::UNREACHABLE)
+        return false;
+    this -> h[this -> target] = 0;
+    pushOpen(source);
+    this -> done = false;
+    return true;
+}
+
+// expand until the goal's g is no more than the lowest open key (epsilon optimal)
+// returns false if the limit stopped it first; the round resumes on the next call
+
+bool AnytimePlanner::improvePath(SearchLimit & limit)
+{
+    int vCount = this -> graph -> getVertexCount();
+    std::greater<std::pair<long long, int>> later;
+    while (!this -> open.empty())
+    {
+        std::pair<long long, int> top = this -> open.front();
+        int u = top.second;
+        if (this -> closed[u] == this -> round || top.first != key(u))
+        {
+            std::pop_heap(this -> open.begin(), this -> open.end(), later);
+            this -> open.pop_back();
+            continue;
+        }
+        if (this -> g[this -> target] >= 0 && (long long) SCALE * this -> g[this -> target] <= top.first)
+            return true;
+        if (limit.shouldStop())
+            return false;
+        std::pop_heap(this -> open.begin(), this -> open.end(), later);
+        this -> open.pop_back();
+        this -> closed[u] = this -> round;
+        this -> expanded++;
+
+        int layer = (u >= vCount) ? vCount : 0;
+        int pivot = u - layer;
+        for (int e = this -> graph -> getFirstEdge(pivot); e < this -> graph -> getLastEdge(pivot); e++)
+        {
+            int v = this -> graph -> getTarget(e);
+            int next = v + ((layer > 0 || this -> graph -> getVertex(v).getC()) ? vCount : 0);
+            int ng = this -> g[u] + this -> graph -> getWeight(e);
+            touch(next);
+            if (this -> g[next] >= 0 && ng >= this -> g[next])
+                continue;
+            if (this -> h[next] < 0)
+                this -> h[next] = estimate(next);
+            if (this -> h[next] >= Heuristic::UNREACHABLE)
+                continue;
+            this -> g[next] = ng;
+            this -> parent[next] = u;
+            if (this -> closed[next] != this -> round)
+                pushOpen(next);
+            else if (!this -> inconsistent[next])
+            {
+                this -> inconsistent[next] = 1;
+                this -> incons.push_back(next);
+            }
+        }
+    }
+    return true;
+}
+
+// the round's route, with the bound from the lowest unexpanded g + h
+
+void AnytimePlanner::publish()
+{
+    int length = this -> g[this -> target];
+    if (length < 0)
+        return;
+    long long lowest = (long long) length;
+    for (size_t i = 0; i < this -> open.size(); i++)
+    {
+        int s = this -> open[i].second;
+        if (this -> closed[s] != this -> round && this -> open[i].first == key(s))
+            lowest = std::min(lowest, (long long) this -> g[s] + this -> h[s]);
+    }
+    for (size_t i = 0; i < this -> incons.size(); i++)
+        lowest = std::min(lowest, (long long) this -> g[this -> incons[i]] + this -> h[this -> incons[i]]);
+    double bound = std::min((double) this -> epsilon / SCALE, (lowest > 0) ? (double) length / lowest : 1.0);
+
+    std::vector<int> route;
+    int vCount = this -> graph -> getVertexCount();
+    for (int s = this -> target; s >= 0; s = this -> parent[s])
+        route.push_back(s % vCount);
+    std::reverse(route.begin(), route.end());
+
+    std::lock_guard<std::mutex> guard(this -> lock);
+    this -> bestRoute.swap(route);
+    this -> bestLength = length;
+    this -> bestBound = std::max(1.0, bound);
+}
+
+// OPEN = OPEN + INCONS with keys for the new epsilon, CLOSED emptied by a new round number
+// an open state has exactly one entry whose key matches its g (keys only drop),
+// and INCONS states were closed, so the two sets never overlap
+
+void AnytimePlanner::reopen(int previousEpsilon)
+{
+    std::vector<std::pair<long long, int>> previous;
+    previous.swap(this -> open);
+    for (size_t i = 0; i < previous.size(); i++)
+    {
+        int s = previous[i].second;
+        if (this -> closed[s] != this -> round && previous[i].first == (long long) SCALE * this -> g[s] + (long long) previousEpsilon * this -> h[s])
+            this -> open.push_back(std::make_pair(key(s), s));
+    }
+    for (size_t i = 0; i < this -> incons.size(); i++)
+    {
+        int s = this -> incons[i];
+        this -> inconsistent[s] = 0;
+        this -> open.push_back(std::make_pair(key(s), s));
+    }
+    this -> incons.clear();
+    this -> round++;
+    std::make_heap(this -> open.begin(), this -> open.end(), std::greater<std::pair<long long, int>>());
+}
+
+// one round: returns true when it finished (a route, if any, is published)
+// and false if the deadline cut it short or the search is already done
+
+bool AnytimePlanner::improve(std::chrono::steady_clock::time_point deadline)
+{
+    SearchLimit limit(deadline);
+    return improve(limit);
+}
+
+// the same under a deadline and/or cancellation token
+
+bool AnytimePlanner::improve(SearchLimit & limit)
+{
+    if (this -> done)
+        return false;
+    if (!improvePath(limit))
+        return false;
+    publish();
+    if (this -> epsilon == SCALE || this -> g[this -> target] < 0)
+    {
+        this -> done = true;
+        if (this -> g[this -> target] >= 0)
+        {
+            std::lock_guard<std::mutex> guard(this -> lock);
+            this -> bestBound = 1.0;
+        }
+        return true;
+    }
+    int previous = this -> epsilon;
+    this -> epsilon = std::max(SCALE, this -> epsilon - this -> step);
+    reopen(previous);
+    return true;
+}
+
+// rounds from epsilon 3 down by 0.5 until optimal or the deadline
+// returns the best route length found in time, or -1
+
+int AnytimePlanner::coffeeRoute(int start, int goal, std::vector<int> & route, std::chrono::steady_clock::time_point deadline)
+{
+    double bound;
+    if (begin(start, goal, 3.0, 0.5))
+        while (improve(deadline))
+            ;
+    return getBest(route, bound);
+}
+
+// the same under a limit: cut short, the result is EXPIRED or CANCELLED with the
+// best route published so far (length -1 if none yet)
+
+SearchResult AnytimePlanner::coffeeRoute(int start, int goal, std::vector<int> & route, SearchLimit & limit)
+{
+    double bound;
+    if (begin(start, goal, 3.0, 0.5) && !limit.checkNow())
+        while (improve(limit))
+            ;
+    return limit.finish(getBest(route, bound));
+}
+
+// a far corner-to-corner query: each round's route and bound as it is published
+
+void runAnytimePlanner()
+{
+    std::cout << "Anytime planner testing will start.";
+
+    FloorMap floor;
+    FloorGenerator::generate("rooms", 1200, 1200, 6, 45, floor);
+    std::vector<Vertex> U;
+    std::vector<Edge> edgeVector;
+    floor.makeEdgesAndVertices(U, edgeVector);
+    FloorGraph graph(U, edgeVector);
+    int start = 0;
+    int goal = graph.getVertexCount() - 1;
+
+    ManhattanHeuristic manhattan(graph);
+    AnytimePlanner planner(graph, manhattan);
+    std::vector<int> route;
+    double bound = 0.0;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point deadline = t0 + std::chrono::seconds(30);
+    planner.begin(start, goal, 3.0, 0.5);
+    while (true)
+    {
+        double epsilon = planner.getEpsilon();
+        if (!planner.improve(deadline))
+            break;
+        int length = planner.getBest(route, bound);
+        std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+        std::cout << "\nepsilon " << epsilon << ": length " << length << ", bound " << bound << ", ";
+        std::cout << planner.getExpandedCount() << " expanded, ";
+        std::cout << std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count() << " ms.";
+    }
+
+    DijkstraPlanner exact(graph);
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+    int best = exact.coffeeRoute(start, goal, route);
+    std::chrono::steady_clock::time_point t3 = std::chrono::steady_clock::now();
+    std::cout << "\nDijkstra: length " << best << ", ";
+    std::cout << std::chrono::duration_cast<std::chrono::milliseconds>(t3 - t2).count() << " ms.";
+}
+
+#endif /* anytimePlanner_h */
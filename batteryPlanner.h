@@ -0,0 +1,434 @@
+//  batteryPlanner.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Battery-constrained coffee routes by label setting with dominance pruning.
+
+#ifndef batteryPlanner_h
+#define batteryPlanner_h
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "floorGenerator.h"
+#include "floorGraph.h"
+#include "searchLimit.h"
+#include "weightedSearch.h"
+
+// every edge uses as much charge as it costs to travel (carpet and ramps drain
+// more) and a move needs that much charge left; entering a charger cell refills
+// the battery to capacity
+// a label is (distance, charge, hasCoffee) at a vertex, with a parent label for
+// the route; label a dominates b at the same vertex if a is no longer, has no
+// less charge and carries coffee whenever b does, since every way on from b is
+// then open to a at no greater cost
+// labels leave the bucket queue in distance order, so a label reaching a vertex
+// after one with at least as much charge is dominated and dropped; the labels
+// kept at each (vertex, coffee) state form its Pareto front, chained from the
+// newest, with charge rising along the front, so a front never holds more than
+// capacity + 1 labels and the first label popped at the goal is optimal
+
+class BatteryPlanner
+{
+    private: // data elements
+        struct Label
+        {
+            int state;
+            int dist;
+            int charge;
+            int parent;
+            int nextAtState;
+        };
+
+        const FloorGraph * graph;
+        int capacity;
+        std::vector<uint64_t> chargerBits;
+        int chargers;
+        BucketQueue queue;
+        std::vector<Label> labels;
+        std::vector<int> front;
+        std::vector<int> bestCharge;
+        int arrivalCharge;
+        int kept;
+
+    public:
+        BatteryPlanner(const FloorGraph &, int);
+
+    public: // accessors
+        int getCapacity() const;
+        int getChargerCount() const;
+        bool isCharger(int) const;
+        int getArrivalCharge() const;
+        int getLabelCount() const;
+        int getKeptCount() const;
+        int getFront(int, bool, std::vector<int> &, std::vector<int> &) const;
+
+    public: // mutators
+        void setCapacity(int);
+        bool addCharger(int);
+        bool addChargerCell(int, int);
+        void clearChargers();
+
+    public: // queries
+        int shortestPath(int, int, int, std::vector<int> &);
+        int coffeeRoute(int, int, int, std::vector<int> &);
+        SearchResult shortestPath(int, int, int, std::vector<int> &, SearchLimit &);
+        SearchResult coffeeRoute(int, int, int, std::vector<int> &, SearchLimit &);
+        int replay(const std::vector<int> &, int) const;
+
+    private:
+        int search(int, int, int, bool, SearchLimit *);
+        void traceLabels(int, std::vector<int> &) const;
+};
+
+BatteryPlanner::BatteryPlanner(const FloorGraph & g, int fullCharge)
+{
+    this -> graph = & g;
+    this -> capacity = std::max(0, fullCharge);
+    this -> chargerBits.assign((g.getVertexCount() + 63) / 64, 0);
+    this -> chargers = 0;
+    this -> arrivalCharge = -1;
+    this -> kept = 0;
+}
+
+int BatteryPlanner::getCapacity() const
+{
+    return this -> capacity;
+}
+
+int BatteryPlanner::getChargerCount() const
+{
+    return this -> chargers;
+}
+
+bool BatteryPlanner::isCharger(int v) const
+{
+    return (this -> chargerBits[v >> 6] >> (v & 63)) & 1;
+}
+
+// charge left on arrival at the goal by the last route found (-1 if none)
+
+int BatteryPlanner::getArrivalCharge() const
+{
+    return this -> arrivalCharge;
+}
+
+// labels created by the last query, and how many of them joined a front
+
+int BatteryPlanner::getLabelCount() const
+{
+    return (int) this -> labels.size();
+}
+
+int BatteryPlanner::getKeptCount() const
+{
+    return this -> kept;
+}
+
+// the (distance, charge) front the last query built at v, shortest first
+// returns its size
+
+int BatteryPlanner::getFront(int v, bool coffee, std::vector<int> & distOut, std::vector<int> & chargeOut) const
+{
+    distOut.clear();
+    chargeOut.clear();
+    int state = v + (coffee ? this -> graph -> getVertexCount() : 0);
+    if (v < 0 || v >= this -> graph -> getVertexCount() || state >= (int) this -> front.size())
+        return 0;
+    for (int l = this -> front[state]; l >= 0; l = this -> labels[l].nextAtState)
+    {
+        distOut.push_back(this -> labels[l].dist);
+        chargeOut.push_back(this -> labels[l].charge);
+    }
+    std::reverse(distOut.begin(), distOut.end());
+    std::reverse(chargeOut.begin(), chargeOut.end());
+    return (int) distOut.size();
+}
+
+void BatteryPlanner::setCapacity(int fullCharge)
+{
+    this -> capacity = std::max(0, fullCharge);
+}
+
+// returns false for an id outside the graph
+
+bool BatteryPlanner::addCharger(int v)
+{
+    if (v < 0 || v >= this -> graph -> getVertexCount())
+        return false;
+    if (!isCharger(v))
+    {
+        this -> chargerBits[v >> 6] |= 1ULL << (v & 63);
+        this -> chargers++;
+    }
+    return true;
+}
+
+bool BatteryPlanner::addChargerCell(int x, int y)
+{
+    return addCharger(this -> graph -> findId(x, y));
+}
+
+void BatteryPlanner::clearChargers()
+{
+    std::fill(this -> chargerBits.begin(), this -> chargerBits.end(), 0);
+    this -> chargers = 0;
+}
+
+// shortest source -> target route the battery can drive, starting with charge
+// returns the route length, or -1 if no such route exists
+
+int BatteryPlanner::shortestPath(int source, int target, int charge, std::vector<int> & route)
+{
+    route.clear();
+    int vCount = this -> graph -> getVertexCount();
+    if (source < 0 || source >= vCount || target < 0 || target >= vCount)
+        return -1;
+    int rv = search(source, target, charge, false, nullptr);
+    if (rv >= 0)
+        traceLabels(this -> front[target], route);
+    return rv;
+}
+
+// shortest start -> any coffee station -> goal route the battery can drive
+
+int BatteryPlanner::coffeeRoute(int start, int goal, int charge, std::vector<int> & route)
+{
+    route.clear();
+    int vCount = this -> graph -> getVertexCount();
+    if (start < 0 || start >= vCount || goal < 0 || goal >= vCount)
+        return -1;
+    int source = start + (this -> graph -> getVertex(start).getC() ? vCount : 0);
+    int rv = search(source, goal + vCount, charge, true, nullptr);
+    if (rv >= 0)
+        traceLabels(this -> front[goal + vCount], route);
+    return rv;
+}
+
+// under a deadline or cancellation token, checked once per label popped;
+// a search cut short returns no route
+
+SearchResult BatteryPlanner::shortestPath(int source, int target, int charge, std::vector<int> & route, SearchLimit & limit)
+{
+    route.clear();
+    int vCount = this -> graph -> getVertexCount();
+    if (source < 0 || source >= vCount || target < 0 || target >= vCount)
+        return limit.finish(-1);
+    int rv = search(source, target, charge, false, & limit);
+    if (rv >= 0)
+        traceLabels(this -> front[target], route);
+    return limit.finish(rv);
+}
+
+SearchResult BatteryPlanner::coffeeRoute(int start, int goal, int charge, std::vector<int> & route, SearchLimit & limit)
+{
+    route.clear();
+    int vCount = this -> graph -> getVertexCount();
+    if (start < 0 || start >= vCount || goal < 0 || goal >= vCount)
+        return limit.finish(-1);
+    int source = start + (this -> graph -> getVertex(start).getC() ? vCount : 0);
+    int rv = search(source, goal + vCount, charge, true, & limit);
+    if (rv >= 0)
+        traceLabels(this -> front[goal + vCount], route);
+    return limit.finish(rv);
+}
+
+// drives route from charge under this planner's rules
+// returns the charge left at the end, or -1 if the battery runs flat or a step is no edge
+
+int BatteryPlanner::replay(const std::vector<int> & route, int charge) const
+{
+    if (route.empty())
+        return -1;
+    charge = isCharger(route[0]) ? this -> capacity : std::min(charge, this -> capacity);
+    for (size_t i = 1; i < route.size(); i++)
+    {
+        int w = -1;
+        for (int e = this -> graph -> getFirstEdge(route[i - 1]); e < this -> graph -> getLastEdge(route[i - 1]); e++)
+            if (this -> graph -> getTarget(e) == route[i])
+                w = this -> graph -> getWeight(e);
+        if (w < 0 || w > charge)
+            return -1;
+        charge = isCharger(route[i]) ? this -> capacity : charge - w;
+    }
+    return charge;
+}
+
+// states are v (no coffee yet) and v + V (coffee carried), as in DijkstraPlanner;
+// bestCharge holds the most charge of a kept label at each state, and in coffee
+// mode a state without coffee is also dominated by its coffee twin
+
+int BatteryPlanner::search(int source, int target, int charge, bool coffee, SearchLimit * limit)
+{
+    int vCount = this -> graph -> getVertexCount();
+    int states = coffee ? 2 * vCount : vCount;
+    this -> labels.clear();
+    this -> front.assign(states, -1);
+    this -> bestCharge.assign(states, -1);
+    this -> arrivalCharge = -1;
+    this -> kept = 0;
+    if (charge < 0)
+        return -1;
+
+    int first = source % vCount;
+    Label root;
+    root.state = source;
+    root.dist = 0;
+    root.charge = isCharger(first) ? this -> capacity : std::min(charge, this -> capacity);
+    root.parent = -1;
+    root.nextAtState = -1;
+    this -> labels.push_back(root);
+    this -> queue.setMaxWeight(this -> graph -> getMaxWeight());
+    this -> queue.push(0, 0);
+
+    int l;
+    int key;
+    while (this -> queue.pop(l, key))
+    {
+        if (limit != nullptr && limit -> shouldStop())
+            return -1;
+        Label label = this -> labels[l];
+        int u = label.state;
+        int dominating = this -> bestCharge[u];
+        if (coffee && u < vCount)
+            dominating = std::max(dominating, this -> bestCharge[u + vCount]);
+        if (label.charge <= dominating)
+            continue;
+        this -> bestCharge[u] = label.charge;
+        this -> labels[l].nextAtState = this -> front[u];
+        this -> front[u] = l;
+        this -> kept++;
+        if (u == target)
+        {
+            this -> arrivalCharge = label.charge;
+            return key;
+        }
+
+        int layer = (u >= vCount) ? vCount : 0;
+        int pivot = u - layer;
+        for (int e = this -> graph -> getFirstEdge(pivot); e < this -> graph -> getLastEdge(pivot); e++)
+        {
+            int w = this -> graph -> getWeight(e);
+            if (w > label.charge)
+                continue;
+            int v = this -> graph -> getTarget(e);
+            int next = v + layer;
+            if (coffee && layer == 0 && this -> graph -> getVertex(v).getC())
+                next = v + vCount;
+            int left = isCharger(v) ? this -> capacity : label.charge - w;
+            int best = this -> bestCharge[next];
+            if (coffee && next < vCount)
+                best = std::max(best, this -> bestCharge[next + vCount]);
+            if (left <= best)
+                continue;
+
+            Label child;
+            child.state = next;
+            child.dist = key + w;
+            child.charge = left;
+            child.parent = l;
+            child.nextAtState = -1;
+            this -> labels.push_back(child);
+            this -> queue.push((int) this -> labels.size() - 1, child.dist);
+        }
+    }
+    return -1;
+}
+
+void BatteryPlanner::traceLabels(int l, std::vector<int> & route) const
+{
+    int vCount = this -> graph -> getVertexCount();
+    for (; l >= 0; l = this -> labels[l].parent)
+        route.push_back(this -> labels[l].state % vCount);
+    std::reverse(route.begin(), route.end());
+}
+
+void runBatteryPlanner()
+{
+    std::cout << "Battery planner testing will start.";
+
+    // demo floor with a charger at (0, 2): a full battery of 12 covers the
+    // shortest route, 10 and 8 only by the far station past the charger, 6 none
+
+    FloorMap floor = FloorMap::demoFloor();
+    floor.printMap();
+    std::vector<Vertex> U;
+    std::vector<Edge> edgeVector;
+    floor.makeEdgesAndVertices(U, edgeVector);
+    FloorGraph graph(U, edgeVector);
+    BatteryPlanner planner(graph, 12);
+    planner.addChargerCell(0, 2);
+    DijkstraPlanner dijkstra(graph);
+
+    std::vector<int> route;
+    int start = graph.findId(3, 2);
+    int goal = graph.findId(3, 4);
+    int unlimited = dijkstra.coffeeRoute(start, goal, route);
+    std::cout << "\nUnconstrained coffee route of cost " << unlimited << ".";
+    for (int capacity = 12; capacity >= 6; capacity -= 2)
+    {
+        planner.setCapacity(capacity);
+        int length = planner.coffeeRoute(start, goal, capacity, route);
+        std::cout << "\nCapacity " << capacity << ": ";
+        if (length < 0)
+            std::cout << "no feasible route.";
+        else
+        {
+            std::cout << "cost " << length << ", " << planner.getArrivalCharge() << " left:";
+            graph.printRoute(route);
+        }
+    }
+
+    // rooms floor with a few chargers: longer routes as the battery shrinks,
+    // every route replayed under the charge rules
+
+    FloorMap rooms;
+    FloorGenerator::generate("rooms", 160, 160, 4, 49, rooms);
+    U.clear();
+    edgeVector.clear();
+    rooms.makeEdgesAndVertices(U, edgeVector);
+    FloorGraph big(U, edgeVector);
+    FloorGenerator random(7);
+    BatteryPlanner bigPlanner(big, 1000);
+    for (int i = 0; i < 12; i++)
+        bigPlanner.addCharger(random.below(big.getVertexCount()));
+    DijkstraPlanner bigDijkstra(big);
+
+    const int QUERIES = 50;
+    std::vector<int> starts;
+    std::vector<int> goals;
+    for (int q = 0; q < QUERIES; q++)
+    {
+        starts.push_back(random.below(big.getVertexCount()));
+        goals.push_back(random.below(big.getVertexCount()));
+    }
+    std::cout << "\n" << big.getVertexCount() << " vertices, " << bigPlanner.getChargerCount() << " chargers, " << QUERIES << " coffee queries.";
+    int capacities [4] = { 1000, 300, 150, 80 };
+    for (int c = 0; c < 4; c++)
+    {
+        bigPlanner.setCapacity(capacities[c]);
+        int feasible = 0;
+        int bad = 0;
+        long long extra = 0;
+        long long labelCount = 0;
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        for (int q = 0; q < QUERIES; q++)
+        {
+            int length = bigPlanner.coffeeRoute(starts[q], goals[q], capacities[c], route);
+            labelCount += bigPlanner.getLabelCount();
+            if (length < 0)
+                continue;
+            feasible++;
+            std::vector<int> plain;
+            int shortest = bigDijkstra.coffeeRoute(starts[q], goals[q], plain);
+            extra += length - shortest;
+            if (length < shortest || bigPlanner.replay(route, capacities[c]) != bigPlanner.getArrivalCharge() || (int) route.size() != length + 1)
+                bad++;
+        }
+        std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+        std::cout << "\nCapacity " << capacities[c] << ": " << feasible << " feasible, " << extra << " extra steps, ";
+        std::cout << labelCount / QUERIES << " labels per query, ";
+        std::cout << std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() / QUERIES << " us per query, bad " << bad << ".";
+    }
+}
+
+#endif /* batteryPlanner_h */
@@ -0,0 +1,362 @@
+//  beamSearch.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Level-by-level coffee route search under a hard memory budget.
+
+#ifndef beamSearch_h
+#define beamSearch_h
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+#include "floorGraph.h"
+#include "floorMap.h"
+#include "searchLimit.h"
+
+// paths are stored as in PathBook, one level per path size, but each path is a
+// (state, parent index) node instead of a copy of all its vertices
+// states are v before the coffee and v + V once it is carried
+
+struct BeamNode
+{
+    int state;
+    int parent;
+};
+
+// a path whose end state was already reached by an earlier or equal level is
+// dropped, which never costs optimality; when the next level would not fit in
+// the budget at its width for every level the Manhattan bound still requires,
+// it is cut to the best beamWidth paths (carrying coffee first, then by that
+// bound); the result is then only optimal if it matches the lower bound
+// the level being built counts against the budget too: each candidate is
+// charged for itself, its two sort scratch slots and its copy into the stored
+// level, and generation prunes in place whenever the candidates reach what is left
+
+class BeamSearch
+{
+    private: // data elements
+        const FloorGraph * graph;
+        std::vector<int> coffee;
+        size_t budget;
+        int beamWidth;
+        std::vector<std::vector<BeamNode>> levels;
+        std::vector<char> reached;
+        size_t bytesUsed;
+        size_t peakBytes;
+        int prunedLevels;
+        bool optimal;
+
+    public:
+        BeamSearch(const FloorGraph &, size_t, int);
+
+    public: // accessors
+        size_t getBytesUsed() const;
+        size_t getPeakBytes() const;
+        int getPrunedLevels() const;
+        bool isOptimal() const;
+
+    public: // queries
+        int coffeeRoute(int, int, std::vector<int> &);
+        SearchResult coffeeRoute(int, int, std::vector<int> &, SearchLimit &);
+
+    private:
+        int search(int, int, std::vector<int> &, SearchLimit *);
+        int manhattan(int, int) const;
+        int score(int, int) const;
+        int lowerBound(int, int) const;
+        void prune(std::vector<BeamNode> &, std::vector<int> &, std::vector<int> &, size_t, int);
+};
+
+BeamSearch::BeamSearch(const FloorGraph & g, size_t budgetBytes, int width)
+{
+    this -> graph = & g;
+    this -> coffee = g.getCoffeeIds();
+    this -> budget = budgetBytes;
+    this -> beamWidth = std::max(1, width);
+    this -> bytesUsed = 0;
+    this -> peakBytes = 0;
+    this -> prunedLevels = 0;
+    this -> optimal = false;
+}
+
+size_t BeamSearch::getBytesUsed() const
+{
+    return this -> bytesUsed;
+}
+
+size_t BeamSearch::getPeakBytes() const
+{
+    return this -> peakBytes;
+}
+
+int BeamSearch::getPrunedLevels() const
+{
+    return this -> prunedLevels;
+}
+
+// true if the last route found is known to have the fewest steps
+
+bool BeamSearch::isOptimal() const
+{
+    return this -> optimal;
+}
+
+int BeamSearch::manhattan(int u, int v) const
+{
+    const Vertex & a = this -> graph -> getVertex(u);
+    const Vertex & b = this -> graph -> getVertex(v);
+    return std::abs(a.getX() - b.getX()) + std::abs(a.getY() - b.getY());
+}
+
+// lower is better: paths carrying coffee sort before the rest
+
+int BeamSearch::score(int state, int goal) const
+{
+    int vCount = this -> graph -> getVertexCount();
+    if (state >= vCount)
+        return manhattan(state - vCount, goal);
+    return (1 << 24) + lowerBound(state, goal);
+}
+
+int BeamSearch::lowerBound(int v, int goal) const
+{
+    int rv = -1;
+    for (size_t i = 0; i < this -> coffee.size(); i++)
+    {
+        int b = manhattan(v, this -> coffee[i]) + manhattan(this -> coffee[i], goal);
+        if (rv < 0 || b < rv)
+            rv = b;
+    }
+    return rv;
+}
+
+// keeps the best keep candidates in their original order; the others are
+// forgotten so a later parent may offer them again
+
+void BeamSearch::prune(std::vector<BeamNode> & candidates, std::vector<int> & order, std::vector<int> & scores, size_t keep, int goal)
+{
+    order.resize(candidates.size());
+    scores.resize(candidates.size());
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+        order[i] = (int) i;
+        scores[i] = score(candidates[i].state, goal);
+    }
+    std::stable_sort(order.begin(), order.end(), [&scores](int a, int b) { return scores[a] < scores[b]; });
+    for (size_t i = keep; i < order.size(); i++)
+        this -> reached[candidates[order[i]].state] = 0;
+    std::sort(order.begin(), order.begin() + keep);
+    for (size_t i = 0; i < keep; i++)
+        candidates[i] = candidates[order[i]];
+    candidates.resize(keep);
+}
+
+// fewest-steps start -> coffee -> goal route, as WorkBook counts it
+// returns the number of steps, or -1 if there is none or the budget ran out
+
+int BeamSearch::coffeeRoute(int start, int goal, std::vector<int> & route)
+{
+    return search(start, goal, route, nullptr);
+}
+
+// under a deadline or cancellation token; a search cut short returns no route
+
+SearchResult BeamSearch::coffeeRoute(int start, int goal, std::vector<int> & route, SearchLimit & limit)
+{
+    return limit.finish(search(start, goal, route, & limit));
+}
+
+// limit is nullptr for an unrestricted search; it is checked once per level
+// and per path of the last level expanded
+
+int BeamSearch::search(int start, int goal, std::vector<int> & route, SearchLimit * limit)
+{
+    route.clear();
+    this -> levels.clear();
+    this -> prunedLevels = 0;
+    this -> optimal = false;
+    int vCount = this -> graph -> getVertexCount();
+    if (start < 0 || start >= vCount || goal < 0 || goal >= vCount || this -> coffee.empty())
+        return -1;
+
+    // 0 unseen, 1 kept in some level, 2 candidate of the level being built
+    // (the one table not pruned, so a budget below it cannot be met at all)
+
+    this -> bytesUsed = 0;
+    this -> peakBytes = 0;
+    if ((size_t) 2 * vCount + sizeof(BeamNode) + sizeof(std::vector<BeamNode>) > this -> budget)
+        return -1;
+    this -> reached.assign(2 * vCount, 0);
+    this -> bytesUsed = this -> reached.size();
+    this -> peakBytes = this -> bytesUsed;
+    int target = goal + vCount;
+    int source = start + (this -> graph -> getVertex(start).getC() ? vCount : 0);
+    BeamNode first = { source, -1 };
+    this -> levels.push_back(std::vector<BeamNode>(1, first));
+    this -> reached[source] = 1;
+    this -> bytesUsed += sizeof(BeamNode) + sizeof(std::vector<BeamNode>);
+
+    const size_t CHARGE = 2 * sizeof(BeamNode) + 2 * sizeof(int);
+    int found = (source == target) ? 0 : -1;
+    while (found < 0 && !this -> levels.back().empty())
+    {
+        if (limit != nullptr && limit -> checkNow())
+        {
+            this -> levels.clear();
+            return -1;
+        }
+        const std::vector<BeamNode> & last = this -> levels.back();
+        size_t held = this -> bytesUsed + sizeof(std::vector<BeamNode>);
+        size_t room = (this -> budget > held) ? this -> budget - held : 0;
+        size_t most = room / CHARGE;
+        if (most < 2)
+        {
+            this -> levels.clear();
+            return -1;
+        }
+
+        // scratch sized once for the level, never past what is left of the budget
+
+        size_t offered = 0;
+        for (size_t p = 0; p < last.size(); p++)
+        {
+            int pivot = last[p].state % vCount;
+            offered += (size_t) (this -> graph -> getLastEdge(pivot) - this -> graph -> getFirstEdge(pivot));
+        }
+        std::vector<BeamNode> candidates;
+        std::vector<int> order;
+        std::vector<int> scores;
+        candidates.reserve(std::min(offered, most));
+        bool cut = false;
+        for (size_t p = 0; p < last.size() && found < 0; p++)
+        {
+            if (limit != nullptr && limit -> shouldStop())
+            {
+                this -> levels.clear();
+                return -1;
+            }
+            int layer = (last[p].state >= vCount) ? vCount : 0;
+            int pivot = last[p].state - layer;
+            for (int e = this -> graph -> getFirstEdge(pivot); e < this -> graph -> getLastEdge(pivot); e++)
+            {
+                int v = this -> graph -> getTarget(e);
+                int next = v + ((layer > 0 || this -> graph -> getVertex(v).getC()) ? vCount : 0);
+                if (this -> reached[next] != 0)
+                    continue;
+                if (candidates.size() == most)
+                {
+                    order.reserve(most);
+                    scores.reserve(most);
+                    prune(candidates, order, scores, std::min((size_t) this -> beamWidth, most / 2), goal);
+                    cut = true;
+                }
+                this -> reached[next] = 2;
+                BeamNode node = { next, (int) p };
+                candidates.push_back(node);
+                if (next == target)
+                {
+                    found = (int) candidates.size() - 1;
+                    break;
+                }
+            }
+        }
+
+        // goal found: keep just that path
+
+        if (found >= 0)
+        {
+            BeamNode node = candidates[found];
+            candidates.assign(1, node);
+            found = 0;
+        }
+
+        // prune once the rest of the route, at this width, could no longer fit
+        // (remaining is the bound on the levels still needed to reach the goal)
+
+        int remaining = 0;
+        if (found < 0)
+        {
+            remaining = -1;
+            for (size_t i = 0; i < candidates.size(); i++)
+            {
+                int s = candidates[i].state;
+                int b = (s >= vCount) ? manhattan(s - vCount, goal) : lowerBound(s, goal);
+                if (remaining < 0 || b < remaining)
+                    remaining = b;
+            }
+        }
+        size_t fit = room / sizeof(BeamNode) / (size_t) (std::max(0, remaining) + 1);
+        if (candidates.size() > fit)
+        {
+            size_t keep = std::min(fit, (size_t) this -> beamWidth);
+            if (keep == 0)
+                keep = 1;
+            order.reserve(most);
+            scores.reserve(most);
+            prune(candidates, order, scores, keep, goal);
+            cut = true;
+        }
+        if (cut)
+            this -> prunedLevels++;
+
+        for (size_t i = 0; i < candidates.size(); i++)
+            this -> reached[candidates[i].state] = 1;
+        size_t scratch = candidates.capacity() * sizeof(BeamNode) + (order.capacity() + scores.capacity()) * sizeof(int);
+        this -> levels.push_back(std::vector<BeamNode>(candidates.begin(), candidates.end()));
+        this -> bytesUsed += candidates.size() * sizeof(BeamNode) + sizeof(std::vector<BeamNode>);
+        this -> peakBytes = std::max(this -> peakBytes, this -> bytesUsed + scratch);
+    }
+
+    if (found < 0)
+        return -1;
+    int index = 0;
+    for (int level = (int) this -> levels.size() - 1; level >= 0; level--)
+    {
+        route.push_back(this -> levels[level][index].state % vCount);
+        index = this -> levels[level][index].parent;
+    }
+    std::reverse(route.begin(), route.end());
+    int steps = (int) route.size() - 1;
+    int bound = this -> graph -> getVertex(start).getC() ? manhattan(start, goal) : lowerBound(start, goal);
+    this -> optimal = (this -> prunedLevels == 0 || steps == bound);
+    return steps;
+}
+
+void runBeamSearch()
+{
+    std::cout << "Beam search will start.";
+
+    // open floor with scattered pillars, coffee in the far corner
+
+    const int SIDE = 1024;
+    FloorMap floor(SIDE, SIDE);
+    for (int y = 0; y < SIDE; y++)
+        for (int x = 0; x < SIDE; x++)
+            if ((x * 7 + y * 13) % 11 == 0)
+                floor.setCell(x, y, '#');
+    floor.setCell(SIDE - 2, SIDE - 2, 'C');
+    std::vector<Vertex> U;
+    std::vector<Edge> edgeVector;
+    floor.makeEdgesAndVertices(U, edgeVector);
+    FloorGraph graph(U, edgeVector);
+    int start = graph.findId(1, 1);
+    int goal = graph.findId(SIDE - 2, 1);
+
+    size_t budgets [3] = { 64u << 20, 8u << 20, 3u << 20 };
+    std::vector<int> route;
+    for (int i = 0; i < 3; i++)
+    {
+        BeamSearch search(graph, budgets[i], 256);
+        int steps = search.coffeeRoute(start, goal, route);
+        std::cout << "\nBudget " << (budgets[i] >> 10) << " KiB: ";
+        if (steps < 0)
+            std::cout << "no route.";
+        else
+        {
+            std::cout << steps << " steps, peak " << (search.getPeakBytes() >> 10) << " KiB, ";
+            std::cout << search.getPrunedLevels() << " levels pruned, ";
+            std::cout << (search.isOptimal() ? "provably optimal." : "not proven optimal.");
+        }
+    }
+}
+
+#endif /* beamSearch_h */
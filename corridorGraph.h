@@ -0,0 +1,512 @@
+//  corridorGraph.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Corridor contraction: chains of degree 2 cells collapsed into weighted edges.
+
+#ifndef corridorGraph_h
+#define corridorGraph_h
+#include <chrono>
+#include <vector>
+#include "floorGenerator.h"
+#include "floorGraph.h"
+#include "searchLimit.h"
+#include "weightedSearch.h"
+
+// a cell is kept unless it has exactly two neighbours and is not a coffee station
+// (or a cell the caller asks to keep); every run of removed cells between two
+// kept cells becomes one chain, searched as a single edge in each direction
+// whose weight is the sum of the cells' edges, and written back out cell by cell
+// a start or goal inside a chain enters or leaves it at both ends, so queries
+// need not rebuild the reduction; a ring with no kept cell keeps one of its cells
+//
+// reduced states follow DijkstraPlanner: r, or r + K once coffee is carried
+
+class CorridorGraph
+{
+    private: // chains
+        class Chain
+        {
+            public:
+                int a;
+                int b;
+                int first;
+                int last;
+                int forward;
+                int backward;
+        };
+
+    private: // data elements
+        const FloorGraph * graph;
+        std::vector<int> keptId;
+        std::vector<int> keptVertex;
+        std::vector<int> offsets;
+        std::vector<int> targets;
+        std::vector<int> weights;
+        std::vector<int> edgeChain;
+        std::vector<char> edgeReversed;
+        std::vector<Chain> chains;
+        std::vector<int> chainCells;
+        std::vector<int> prefixForward;
+        std::vector<int> prefixBackward;
+        std::vector<int> chainOf;
+        std::vector<int> slotOf;
+        int maxWeight;
+
+    private: // search scratch space
+        BucketQueue queue;
+        std::vector<int> dist;
+        std::vector<int> parent;
+        std::vector<int> parentEdge;
+        int settled;
+
+    public:
+        CorridorGraph(const FloorGraph &);
+        CorridorGraph(const FloorGraph &, const std::vector<int> &);
+
+    public: // accessors
+        int getKeptCount() const;
+        int getReducedEdgeCount() const;
+        int getChainCount() const;
+        int getSettledCount() const;
+
+    public: // queries
+        int coffeeRoute(int, int, std::vector<int> &);
+        SearchResult coffeeRoute(int, int, std::vector<int> &, SearchLimit &);
+
+    private:
+        int search(int, int, std::vector<int> &, SearchLimit *);
+        void build(const std::vector<int> &);
+        int edgeWeight(int, int) const;
+        void appendEdge(int, std::vector<int> &) const;
+};
+
+CorridorGraph::CorridorGraph(const FloorGraph & g)
+{
+    this -> graph = & g;
+    build(std::vector<int>());
+}
+
+// keep lists cells that must stay vertices of the reduced graph (e.g. desks)
+
+CorridorGraph::CorridorGraph(const FloorGraph & g, const std::vector<int> & keep)
+{
+    this -> graph = & g;
+    build(keep);
+}
+
+int CorridorGraph::getKeptCount() const
+{
+    return (int) this -> keptVertex.size();
+}
+
+int CorridorGraph::getReducedEdgeCount() const
+{
+    return (int) this -> targets.size();
+}
+
+int CorridorGraph::getChainCount() const
+{
+    return (int) this -> chains.size();
+}
+
+int CorridorGraph::getSettledCount() const
+{
+    return this -> settled;
+}
+
+// weight of u -> v in the full graph
+
+int CorridorGraph::edgeWeight(int u, int v) const
+{
+    for (int e = this -> graph -> getFirstEdge(u); e < this -> graph -> getLastEdge(u); e++)
+        if (this -> graph -> getTarget(e) == v)
+            return this -> graph -> getWeight(e);
+    return 1;
+}
+
+void CorridorGraph::build(const std::vector<int> & keep)
+{
+    const FloorGraph & g = *(this -> graph);
+    int vCount = g.getVertexCount();
+    this -> keptId.assign(vCount, -1);
+    this -> chainOf.assign(vCount, -1);
+    this -> slotOf.assign(vCount, -1);
+    this -> maxWeight = 1;
+    for (int v = 0; v < vCount; v++)
+        if (g.getLastEdge(v) - g.getFirstEdge(v) != 2 || g.getVertex(v).getC())
+            this -> keptId[v] = 0;
+    for (size_t i = 0; i < keep.size(); i++)
+        if (keep[i] >= 0 && keep[i] < vCount)
+            this -> keptId[keep[i]] = 0;
+    for (int v = 0; v < vCount; v++)
+        if (this -> keptId[v] == 0)
+        {
+            this -> keptId[v] = (int) this -> keptVertex.size();
+            this -> keptVertex.push_back(v);
+        }
+
+    // walk out of every kept cell along each of its edges; a chain is stored by the
+    // first walk through it and the walk from its other end uses it reversed
+    // (keptVertex grows while it is scanned when a ring needs a kept cell)
+
+    std::vector<int> from;
+    std::vector<int> to;
+    std::vector<int> weight;
+    std::vector<int> chain;
+    std::vector<char> reversed;
+    int ring = 0;
+    for (size_t k = 0; k <= this -> keptVertex.size(); k++)
+    {
+        if (k == this -> keptVertex.size())
+        {
+            for (; ring < vCount; ring++)
+                if (this -> keptId[ring] < 0 && this -> chainOf[ring] < 0)
+                {
+                    this -> keptId[ring] = (int) this -> keptVertex.size();
+                    this -> keptVertex.push_back(ring);
+                    break;
+                }
+            if (k == this -> keptVertex.size())
+                break;
+        }
+        int a = this -> keptVertex[k];
+        for (int e = g.getFirstEdge(a); e < g.getLastEdge(a); e++)
+        {
+            int previous = a;
+            int current = g.getTarget(e);
+            int forward = g.getWeight(e);
+            int backward = edgeWeight(current, a);
+            if (this -> keptId[current] >= 0)
+            {
+                from.push_back(this -> keptId[a]);
+                to.push_back(this -> keptId[current]);
+                weight.push_back(forward);
+                chain.push_back(-1);
+                reversed.push_back(0);
+                continue;
+            }
+            if (this -> chainOf[current] >= 0)
+            {
+                const Chain & c = this -> chains[this -> chainOf[current]];
+                from.push_back(this -> keptId[a]);
+                to.push_back(this -> keptId[c.a]);
+                weight.push_back(c.backward);
+                chain.push_back(this -> chainOf[current]);
+                reversed.push_back(1);
+                continue;
+            }
+
+            Chain c;
+            c.a = a;
+            c.first = (int) this -> chainCells.size();
+            int id = (int) this -> chains.size();
+            while (this -> keptId[current] < 0)
+            {
+                this -> chainOf[current] = id;
+                this -> slotOf[current] = (int) this -> chainCells.size();
+                this -> chainCells.push_back(current);
+                this -> prefixForward.push_back(forward);
+                this -> prefixBackward.push_back(backward);
+                int next = g.getTarget(g.getFirstEdge(current));
+                if (next == previous)
+                    next = g.getTarget(g.getFirstEdge(current) + 1);
+                forward += edgeWeight(current, next);
+                backward += edgeWeight(next, current);
+                previous = current;
+                current = next;
+            }
+            c.last = (int) this -> chainCells.size();
+            c.b = current;
+            c.forward = forward;
+            c.backward = backward;
+            this -> chains.push_back(c);
+            from.push_back(this -> keptId[a]);
+            to.push_back(this -> keptId[current]);
+            weight.push_back(forward);
+            chain.push_back(id);
+            reversed.push_back(0);
+        }
+    }
+
+    // counting pass, then fill pass, as in FloorGraph
+
+    int kCount = (int) this -> keptVertex.size();
+    this -> offsets.assign(kCount + 1, 0);
+    for (size_t i = 0; i < from.size(); i++)
+        this -> offsets[from[i] + 1]++;
+    for (int r = 0; r < kCount; r++)
+        this -> offsets[r + 1] += this -> offsets[r];
+    this -> targets.assign(from.size(), -1);
+    this -> weights.assign(from.size(), 1);
+    this -> edgeChain.assign(from.size(), -1);
+    this -> edgeReversed.assign(from.size(), 0);
+    std::vector<int> next(this -> offsets.begin(), this -> offsets.end() - 1);
+    for (size_t i = 0; i < from.size(); i++)
+    {
+        int slot = next[from[i]]++;
+        this -> targets[slot] = to[i];
+        this -> weights[slot] = weight[i];
+        this -> edgeChain[slot] = chain[i];
+        this -> edgeReversed[slot] = reversed[i];
+        this -> maxWeight = std::max(this -> maxWeight, weight[i]);
+    }
+}
+
+// the cells of reduced edge e after its tail, its head included
+
+void CorridorGraph::appendEdge(int e, std::vector<int> & route) const
+{
+    int c = this -> edgeChain[e];
+    if (c >= 0)
+    {
+        const Chain & chain = this -> chains[c];
+        if (this -> edgeReversed[e])
+            for (int k = chain.last - 1; k >= chain.first; k--)
+                route.push_back(this -> chainCells[k]);
+        else
+            for (int k = chain.first; k < chain.last; k++)
+                route.push_back(this -> chainCells[k]);
+    }
+    route.push_back(this -> keptVertex[this -> targets[e]]);
+}
+
+// shortest start -> any coffee station -> goal route in full graph ids
+// returns the route length, or -1 if there is none
+
+int CorridorGraph::coffeeRoute(int start, int goal, std::vector<int> & route)
+{
+    return search(start, goal, route, nullptr);
+}
+
+// under a deadline or cancellation token; a search cut short returns no route
+
+SearchResult CorridorGraph::coffeeRoute(int start, int goal, std::vector<int> & route, SearchLimit & limit)
+{
+    return limit.finish(search(start, goal, route, & limit));
+}
+
+// limit is nullptr for an unrestricted search, else checked per reduced state settled
+
+int CorridorGraph::search(int start, int goal, std::vector<int> & route, SearchLimit * limit)
+{
+    route.clear();
+    const FloorGraph & g = *(this -> graph);
+    int vCount = g.getVertexCount();
+    int kCount = (int) this -> keptVertex.size();
+    this -> settled = 0;
+    if (start < 0 || start >= vCount || goal < 0 || goal >= vCount)
+        return -1;
+
+    this -> dist.assign(2 * kCount, -1);
+    this -> parent.assign(2 * kCount, -1);
+    this -> parentEdge.assign(2 * kCount, -1);
+    this -> queue.setMaxWeight(this -> maxWeight);
+
+    // a start inside a chain enters the reduced graph at both chain ends, nearer end
+    // first (coffee stations are always kept, so the coffee can only be an end)
+
+    if (this -> keptId[start] >= 0)
+    {
+        int source = this -> keptId[start] + (g.getVertex(start).getC() ? kCount : 0);
+        this -> dist[source] = 0;
+        this -> queue.push(source, 0);
+    }
+    else
+    {
+        const Chain & c = this -> chains[this -> chainOf[start]];
+        int s = this -> slotOf[start];
+        int ends [2] = { this -> keptId[c.a] + (g.getVertex(c.a).getC() ? kCount : 0),
+                         this -> keptId[c.b] + (g.getVertex(c.b).getC() ? kCount : 0) };
+        int costs [2] = { this -> prefixBackward[s], c.forward - this -> prefixForward[s] };
+        int order = (costs[0] <= costs[1]) ? 0 : 1;
+        for (int i = 0; i < 2; i++)
+        {
+            int k = (order + i) % 2;
+            if (this -> dist[ends[k]] < 0 || costs[k] < this -> dist[ends[k]])
+            {
+                this -> dist[ends[k]] = costs[k];
+                this -> queue.push(ends[k], costs[k]);
+            }
+        }
+    }
+
+    // a goal inside a chain is reached from either end once coffee is carried
+
+    int exits [2] = { -1, -1 };
+    int extra [2] = { 0, 0 };
+    if (this -> keptId[goal] >= 0)
+        exits[0] = this -> keptId[goal] + kCount;
+    else
+    {
+        const Chain & c = this -> chains[this -> chainOf[goal]];
+        int s = this -> slotOf[goal];
+        exits[0] = this -> keptId[c.a] + kCount;
+        extra[0] = this -> prefixForward[s];
+        exits[1] = this -> keptId[c.b] + kCount;
+        extra[1] = c.backward - this -> prefixBackward[s];
+    }
+
+    int best = -1;
+    int bestExit = -1;
+    int u;
+    int key;
+    while (this -> queue.pop(u, key))
+    {
+        if (key != this -> dist[u])
+            continue;
+        if (best >= 0 && key >= best)
+            break;
+        if (limit != nullptr && limit -> shouldStop())
+            return -1;
+        this -> settled++;
+        for (int i = 0; i < 2; i++)
+            if (u == exits[i] && (best < 0 || key + extra[i] < best))
+            {
+                best = key + extra[i];
+                bestExit = i;
+            }
+
+        int layer = (u >= kCount) ? kCount : 0;
+        int pivot = u - layer;
+        for (int e = this -> offsets[pivot]; e < this -> offsets[pivot + 1]; e++)
+        {
+            int r = this -> targets[e];
+            int next = r + ((layer > 0 || g.getVertex(this -> keptVertex[r]).getC()) ? kCount : 0);
+            int nd = key + this -> weights[e];
+            if (this -> dist[next] < 0 || nd < this -> dist[next])
+            {
+                this -> dist[next] = nd;
+                this -> parent[next] = u;
+                this -> parentEdge[next] = e;
+                this -> queue.push(next, nd);
+            }
+        }
+    }
+    if (best < 0)
+        return -1;
+
+    // reduced states back to cells: the partial chain out of the start, every
+    // contracted edge in full, then the partial chain into the goal
+
+    std::vector<int> states;
+    for (int s = exits[bestExit]; s >= 0; s = this -> parent[s])
+        states.push_back(s);
+    std::reverse(states.begin(), states.end());
+
+    route.push_back(start);
+    int first = this -> keptVertex[states[0] % kCount];
+    if (this -> keptId[start] < 0)
+    {
+        const Chain & c = this -> chains[this -> chainOf[start]];
+        int s = this -> slotOf[start];
+        bool towardA = (first == c.a) && (c.a != c.b || this -> prefixBackward[s] <= c.forward - this -> prefixForward[s]);
+        if (towardA)
+            for (int k = s - 1; k >= c.first; k--)
+                route.push_back(this -> chainCells[k]);
+        else
+            for (int k = s + 1; k < c.last; k++)
+                route.push_back(this -> chainCells[k]);
+        route.push_back(first);
+    }
+    for (size_t i = 1; i < states.size(); i++)
+        appendEdge(this -> parentEdge[states[i]], route);
+    if (this -> keptId[goal] < 0)
+    {
+        const Chain & c = this -> chains[this -> chainOf[goal]];
+        int s = this -> slotOf[goal];
+        if (bestExit == 0)
+            for (int k = c.first; k <= s; k++)
+                route.push_back(this -> chainCells[k]);
+        else
+            for (int k = c.last - 1; k >= s; k--)
+                route.push_back(this -> chainCells[k]);
+    }
+    return best;
+}
+
+// corridor-heavy floors: reduced graph size, searched states and time against
+// DijkstraPlanner on the full graph, with every route checked cell by cell
+
+void runCorridorGraph()
+{
+    std::cout << "Corridor contraction testing will start.";
+
+    FloorMap demo = FloorMap::demoFloor();
+    std::vector<Vertex> demoU;
+    std::vector<Edge> demoEdges;
+    demo.makeEdgesAndVertices(demoU, demoEdges);
+    FloorGraph demoGraph(demoU, demoEdges);
+    CorridorGraph demoReduced(demoGraph);
+    std::vector<int> demoRoute;
+    int demoLength = demoReduced.coffeeRoute(demoGraph.findId(3, 2), demoGraph.findId(3, 4), demoRoute);
+    std::cout << "\nDemo floor: " << demoGraph.getVertexCount() << " vertices -> " << demoReduced.getKeptCount() << " kept, ";
+    std::cout << demoReduced.getChainCount() << " chains, route of length " << demoLength << ":";
+    demoGraph.printRoute(demoRoute);
+
+    const char * layouts [2] = { "maze", "rooms" };
+    for (int l = 0; l < 2; l++)
+    {
+        FloorMap floor;
+        FloorGenerator::generate(layouts[l], 600, 600, 6, 47, floor);
+        std::vector<Vertex> U;
+        std::vector<Edge> edgeVector;
+        floor.makeEdgesAndVertices(U, edgeVector);
+        FloorGraph graph(U, edgeVector);
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        CorridorGraph reduced(graph);
+        std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+        DijkstraPlanner full(graph);
+
+        const int QUERIES = 20;
+        FloorGenerator queries(47 + l);
+        std::vector<int> route;
+        std::vector<int> expected;
+        long long fullSettled = 0;
+        long long reducedSettled = 0;
+        long long fullMicros = 0;
+        long long reducedMicros = 0;
+        int mismatches = 0;
+        for (int q = 0; q < QUERIES; q++)
+        {
+            int start = queries.below(graph.getVertexCount());
+            int goal = queries.below(graph.getVertexCount());
+            std::chrono::steady_clock::time_point q0 = std::chrono::steady_clock::now();
+            int a = full.coffeeRoute(start, goal, expected);
+            std::chrono::steady_clock::time_point q1 = std::chrono::steady_clock::now();
+            int b = reduced.coffeeRoute(start, goal, route);
+            std::chrono::steady_clock::time_point q2 = std::chrono::steady_clock::now();
+            fullMicros += std::chrono::duration_cast<std::chrono::microseconds>(q1 - q0).count();
+            reducedMicros += std::chrono::duration_cast<std::chrono::microseconds>(q2 - q1).count();
+            fullSettled += full.getSettledCount();
+            reducedSettled += reduced.getSettledCount();
+
+            // the expanded route must be a walk of that length through a coffee station
+
+            bool ok = (a == b) && (a < 0 || (route.front() == start && route.back() == goal));
+            int length = 0;
+            bool coffee = false;
+            for (size_t i = 0; ok && a >= 0 && i < route.size(); i++)
+            {
+                coffee = coffee || graph.getVertex(route[i]).getC();
+                if (i == 0)
+                    continue;
+                int w = -1;
+                for (int e = graph.getFirstEdge(route[i - 1]); e < graph.getLastEdge(route[i - 1]); e++)
+                    if (graph.getTarget(e) == route[i])
+                        w = graph.getWeight(e);
+                ok = w > 0;
+                length += w;
+            }
+            if (!ok || (a >= 0 && (length != a || !coffee)))
+                mismatches++;
+        }
+
+        std::cout << "\n" << layouts[l] << ": " << graph.getVertexCount() << " vertices -> " << reduced.getKeptCount();
+        std::cout << " kept, " << reduced.getChainCount() << " chains, built in ";
+        std::cout << std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count() << " ms.";
+        std::cout << "\n  settled " << fullSettled << " -> " << reducedSettled << ", ";
+        std::cout << fullMicros / 1000 << " ms -> " << reducedMicros / 1000 << " ms, " << mismatches << " mismatches.";
+    }
+}
+
+#endif /* corridorGraph_h */
@@ -0,0 +1,565 @@
+//  distanceStore.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Distance tables written once and memory-mapped read-only by many planner processes.
+
+#ifndef distanceStore_h
+#define distanceStore_h
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "floorGenerator.h"
+#include "floorGraph.h"
+#include "weightedSearch.h"
+
+// store file (native byte order), every region starting on a PAGE boundary
+//   header page
+//     char[4]   "DST1"
+//     uint32    bytes per distance (2 when a bound on every distance fits in 16 bits, else 4)
+//     uint64    FloorGraph::fingerprint of the map
+//     uint64    generation, raised by the builder on every rebuild
+//     uint32    vertex count V
+//     uint32    source count S
+//     uint64    block bytes (V distances, rounded up to a page)
+//     uint64    checksum of the header fields above and the index
+//     uint64    checksum of the blocks
+//   index     int32[V], the block of each vertex or -1 if it is not a source
+//   blocks    S blocks, block i holding d(source i, v) for every v (all ones if unreached)
+//
+// processes mapping the same file share its pages through the page cache, and a
+// new process can answer from the first page it touches; the builder writes a
+// new version beside the file and renames it over the old one, so a reader sees
+// either version whole, and refresh() moves a reader to the newest version
+// distances are assumed symmetric (FloorGraph edges are stored both ways), so a
+// block also gives the distance from any vertex to its source
+
+class DistanceStore
+{
+    private: // data elements
+        std::string fileName;
+        const char * data;
+        size_t length;
+        uint64_t inode;
+        uint64_t print;
+        uint32_t entryBytes;
+        uint64_t generation;
+        uint32_t vCount;
+        uint32_t sources;
+        uint64_t blockBytes;
+        const int32_t * index;
+        const char * blocks;
+
+    public:
+        static constexpr size_t PAGE = 4096;
+
+    public:
+        DistanceStore();
+        DistanceStore(const DistanceStore &) = delete;
+        DistanceStore & operator=(const DistanceStore &) = delete;
+        ~DistanceStore();
+
+    public: // builder
+        static bool build(const FloorGraph &, const std::vector<int> &, uint64_t, const std::string &);
+
+    public: // accessors
+        bool isOpen() const;
+        uint64_t getGeneration() const;
+        int getSourceCount() const;
+        size_t getFileBytes() const;
+        bool hasSource(int) const;
+        int distance(int, int) const;
+        int nextHop(const FloorGraph &, int, int) const;
+        int coffeeRoute(const FloorGraph &, int, int, std::vector<int> &) const;
+
+    public: // mapping
+        bool open(const std::string &, uint64_t, bool);
+        bool open(const std::string &, const FloorGraph &, bool);
+        bool refresh();
+        void close();
+
+    private:
+        static uint64_t checksum(uint64_t, const char *, size_t);
+        static size_t roundUp(size_t);
+};
+
+DistanceStore::DistanceStore()
+{
+    this -> data = nullptr;
+    this -> length = 0;
+    this -> inode = 0;
+    this -> print = 0;
+    this -> entryBytes = 0;
+    this -> generation = 0;
+    this -> vCount = 0;
+    this -> sources = 0;
+    this -> blockBytes = 0;
+    this -> index = nullptr;
+    this -> blocks = nullptr;
+}
+
+DistanceStore::~DistanceStore()
+{
+    close();
+}
+
+size_t DistanceStore::roundUp(size_t bytes)
+{
+    return (bytes + PAGE - 1) / PAGE * PAGE;
+}
+
+// FNV-1a over 8 byte words (then the tail bytes): one multiply per word keeps
+// verifying a large store close to memory speed
+
+uint64_t DistanceStore::checksum(uint64_t rv, const char * bytes, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        uint64_t word;
+        std::memcpy(& word, bytes + i, 8);
+        rv = (rv ^ word) * 1099511628211ULL;
+    }
+    for (; i < count; i++)
+        rv = (rv ^ (unsigned char) bytes[i]) * 1099511628211ULL;
+    return rv;
+}
+
+// one block per source (e.g. the coffee stations or the desks), BFS or Dijkstra
+// from each, written through a shared mapping of <fileName>.tmp which is then
+// renamed over fileName; returns false if any step fails
+// only one source's distances are held at a time: the first search bounds the
+// rest (d(s, v) <= d(s, r) + d(r, v) <= 2 ecc(r) for s in the component of r),
+// which fixes the entry width before the file is laid out
+
+bool DistanceStore::build(const FloorGraph & g, const std::vector<int> & sourceIds, uint64_t generation, const std::string & fileName)
+{
+    uint32_t vertexCount = (uint32_t) g.getVertexCount();
+    std::vector<int32_t> blockOf(vertexCount, -1);
+    std::vector<int> list;
+    for (size_t i = 0; i < sourceIds.size(); i++)
+        if (sourceIds[i] >= 0 && sourceIds[i] < (int) vertexCount && blockOf[sourceIds[i]] < 0)
+        {
+            blockOf[sourceIds[i]] = (int32_t) list.size();
+            list.push_back(sourceIds[i]);
+        }
+
+    std::vector<int> dist;
+    std::vector<int> parent;
+    DijkstraPlanner dijkstra(g);
+    uint32_t entry = 4;
+    if (!list.empty())
+    {
+        if (g.isWeighted())
+            dijkstra.distances(list[0], dist, parent);
+        else
+            g.bfs(list[0], dist, parent);
+        long long eccentricity = 0;
+        for (uint32_t v = 0; v < vertexCount; v++)
+            eccentricity = std::max(eccentricity, (long long) dist[v]);
+        bool connected = true;
+        for (size_t i = 1; i < list.size(); i++)
+            connected = connected && dist[list[i]] >= 0;
+        if (connected && 2 * eccentricity < 0xffff)
+            entry = 2;
+    }
+    uint64_t block = roundUp((size_t) vertexCount * entry);
+    size_t indexBytes = roundUp((size_t) vertexCount * sizeof(int32_t));
+    size_t total = PAGE + indexBytes + (size_t) block * list.size();
+
+    std::string temporary = fileName + ".tmp";
+    int fd = ::open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+    if (ftruncate(fd, (off_t) total) != 0)
+    {
+        ::close(fd);
+        std::remove(temporary.c_str());
+        return false;
+    }
+    void * mapping = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        ::close(fd);
+        std::remove(temporary.c_str());
+        return false;
+    }
+
+    char * out = (char *) mapping;
+    std::memcpy(out + PAGE, blockOf.data(), (size_t) vertexCount * sizeof(int32_t));
+    for (size_t i = 0; i < list.size(); i++)
+    {
+        if (i > 0 && g.isWeighted())
+            dijkstra.distances(list[i], dist, parent);
+        else if (i > 0)
+            g.bfs(list[i], dist, parent);
+        char * b = out + PAGE + indexBytes + block * i;
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            uint32_t d = (dist[v] < 0) ? 0xffffffffu : (uint32_t) dist[v];
+            if (entry == 2)
+            {
+                uint16_t shortD = (uint16_t) d;
+                std::memcpy(b + (size_t) v * 2, & shortD, 2);
+            }
+            else
+                std::memcpy(b + (size_t) v * 4, & d, 4);
+        }
+    }
+
+    uint64_t mapPrint = g.fingerprint();
+    uint32_t sourceCount = (uint32_t) list.size();
+    std::memcpy(out, "DST1", 4);
+    std::memcpy(out + 4, & entry, 4);
+    std::memcpy(out + 8, & mapPrint, 8);
+    std::memcpy(out + 16, & generation, 8);
+    std::memcpy(out + 24, & vertexCount, 4);
+    std::memcpy(out + 28, & sourceCount, 4);
+    std::memcpy(out + 32, & block, 8);
+    uint64_t headerSum = checksum(checksum(1469598103934665603ULL, out, 40), out + PAGE, indexBytes);
+    uint64_t blockSum = checksum(1469598103934665603ULL, out + PAGE + indexBytes, (size_t) block * list.size());
+    std::memcpy(out + 40, & headerSum, 8);
+    std::memcpy(out + 48, & blockSum, 8);
+
+    bool ok = msync(mapping, total, MS_SYNC) == 0;
+    ok = (munmap(mapping, total) == 0) && ok;
+    ok = (fsync(fd) == 0) && ok;
+    ok = (::close(fd) == 0) && ok;
+    if (!ok || std::rename(temporary.c_str(), fileName.c_str()) != 0)
+    {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool DistanceStore::isOpen() const
+{
+    return this -> data != nullptr;
+}
+
+uint64_t DistanceStore::getGeneration() const
+{
+    return this -> generation;
+}
+
+int DistanceStore::getSourceCount() const
+{
+    return (int) this -> sources;
+}
+
+size_t DistanceStore::getFileBytes() const
+{
+    return this -> length;
+}
+
+bool DistanceStore::hasSource(int v) const
+{
+    return this -> data != nullptr && v >= 0 && v < (int) this -> vCount && this -> index[v] >= 0;
+}
+
+// d(source, v), or -1 if source has no block or v is not reachable
+
+int DistanceStore::distance(int source, int v) const
+{
+    if (!hasSource(source) || v < 0 || v >= (int) this -> vCount)
+        return -1;
+    const char * b = this -> blocks + this -> blockBytes * this -> index[source];
+    if (this -> entryBytes == 2)
+    {
+        uint16_t d;
+        std::memcpy(& d, b + (size_t) v * 2, 2);
+        return (d == 0xffff) ? -1 : d;
+    }
+    uint32_t d;
+    std::memcpy(& d, b + (size_t) v * 4, 4);
+    return (d == 0xffffffffu) ? -1 : (int) d;
+}
+
+// the neighbour of v one step closer to source, or -1 (v is the source or unreachable)
+
+int DistanceStore::nextHop(const FloorGraph & g, int source, int v) const
+{
+    int dv = distance(source, v);
+    if (dv <= 0)
+        return -1;
+    for (int e = g.getFirstEdge(v); e < g.getLastEdge(v); e++)
+    {
+        int n = g.getTarget(e);
+        int dn = distance(source, n);
+        if (dn >= 0 && dn + g.getWeight(e) == dv)
+            return n;
+    }
+    return -1;
+}
+
+// with every coffee station stored as a source: the best station c minimises
+// d(c, start) + d(c, goal), and the route follows next hops start -> c and goal -> c
+// returns the length, or -1 if there is no route or a station has no block
+
+int DistanceStore::coffeeRoute(const FloorGraph & g, int start, int goal, std::vector<int> & route) const
+{
+    route.clear();
+    std::vector<int> coffee = g.getCoffeeIds();
+    int best = -1;
+    int station = -1;
+    for (size_t i = 0; i < coffee.size(); i++)
+    {
+        if (!hasSource(coffee[i]))
+            return -1;
+        int a = distance(coffee[i], start);
+        int b = distance(coffee[i], goal);
+        if (a >= 0 && b >= 0 && (best < 0 || a + b < best))
+        {
+            best = a + b;
+            station = coffee[i];
+        }
+    }
+    if (best < 0)
+        return -1;
+
+    for (int v = start; v >= 0; v = nextHop(g, station, v))
+        route.push_back(v);
+    std::vector<int> back;
+    for (int v = goal; v >= 0 && v != station; v = nextHop(g, station, v))
+        back.push_back(v);
+    route.insert(route.end(), back.rbegin(), back.rend());
+    return best;
+}
+
+// maps fileName read-only if it was built for the map with this fingerprint;
+// the header checksum is always checked, the blocks only with verify (that reads
+// the whole file)
+// returns false (and stays closed) for a missing, damaged or foreign file
+
+bool DistanceStore::open(const std::string & name, uint64_t mapPrint, bool verify)
+{
+    close();
+    int fd = ::open(name.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, & info) != 0 || (size_t) info.st_size < PAGE)
+    {
+        ::close(fd);
+        return false;
+    }
+    size_t size = (size_t) info.st_size;
+    void * mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+    const char * in = (const char *) mapping;
+
+    uint32_t entry = 0;
+    uint64_t filePrint = 0;
+    uint64_t gen = 0;
+    uint32_t vertexCount = 0;
+    uint32_t sourceCount = 0;
+    uint64_t block = 0;
+    uint64_t headerSum = 0;
+    uint64_t blockSum = 0;
+    std::memcpy(& entry, in + 4, 4);
+    std::memcpy(& filePrint, in + 8, 8);
+    std::memcpy(& gen, in + 16, 8);
+    std::memcpy(& vertexCount, in + 24, 4);
+    std::memcpy(& sourceCount, in + 28, 4);
+    std::memcpy(& block, in + 32, 8);
+    std::memcpy(& headerSum, in + 40, 8);
+    std::memcpy(& blockSum, in + 48, 8);
+    size_t indexBytes = roundUp((size_t) vertexCount * sizeof(int32_t));
+
+    bool ok = std::memcmp(in, "DST1", 4) == 0 && (entry == 2 || entry == 4) &&
+              filePrint == mapPrint &&
+              block == roundUp((size_t) vertexCount * entry) &&
+              size == PAGE + indexBytes + (size_t) block * sourceCount;
+    ok = ok && headerSum == checksum(checksum(1469598103934665603ULL, in, 40), in + PAGE, indexBytes);
+    if (ok && verify)
+        ok = blockSum == checksum(1469598103934665603ULL, in + PAGE + indexBytes, (size_t) block * sourceCount);
+    const int32_t * blockOf = (const int32_t *) (in + PAGE);
+    for (uint32_t v = 0; ok && v < vertexCount; v++)
+        ok = blockOf[v] < (int32_t) sourceCount;
+    if (!ok)
+    {
+        munmap(mapping, size);
+        return false;
+    }
+
+    this -> fileName = name;
+    this -> data = in;
+    this -> length = size;
+    this -> inode = (uint64_t) info.st_ino;
+    this -> print = filePrint;
+    this -> entryBytes = entry;
+    this -> generation = gen;
+    this -> vCount = vertexCount;
+    this -> sources = sourceCount;
+    this -> blockBytes = block;
+    this -> index = blockOf;
+    this -> blocks = in + PAGE + indexBytes;
+    madvise(mapping, size, MADV_RANDOM);
+    return true;
+}
+
+// hashing a large graph takes a while; processes that keep the fingerprint pass it instead
+
+bool DistanceStore::open(const std::string & name, const FloorGraph & g, bool verify)
+{
+    return open(name, g.fingerprint(), verify);
+}
+
+// remaps the file if the builder has swapped in a new version since open()
+// returns true if this store now maps the newest valid version
+
+bool DistanceStore::refresh()
+{
+    struct stat info;
+    if (this -> data != nullptr && stat(this -> fileName.c_str(), & info) == 0 && (uint64_t) info.st_ino == this -> inode)
+        return true;
+    std::string name = this -> fileName;
+    DistanceStore fresh;
+    if (!fresh.open(name, this -> print, false))
+        return false;
+    close();
+    std::swap(this -> fileName, fresh.fileName);
+    std::swap(this -> data, fresh.data);
+    std::swap(this -> length, fresh.length);
+    std::swap(this -> inode, fresh.inode);
+    std::swap(this -> print, fresh.print);
+    std::swap(this -> entryBytes, fresh.entryBytes);
+    std::swap(this -> generation, fresh.generation);
+    std::swap(this -> vCount, fresh.vCount);
+    std::swap(this -> sources, fresh.sources);
+    std::swap(this -> blockBytes, fresh.blockBytes);
+    std::swap(this -> index, fresh.index);
+    std::swap(this -> blocks, fresh.blocks);
+    return true;
+}
+
+void DistanceStore::close()
+{
+    if (this -> data != nullptr)
+        munmap((void *) this -> data, this -> length);
+    this -> data = nullptr;
+    this -> length = 0;
+    this -> inode = 0;
+    this -> index = nullptr;
+    this -> blocks = nullptr;
+}
+
+// one builder, then planner processes that map the store and answer at once;
+// then a rebuild swapped in under a running reader, and a damaged copy refused
+
+void runDistanceStore()
+{
+    std::cout << "Distance store testing will start.";
+
+    FloorMap floor;
+    FloorGenerator::generate("rooms", 600, 600, 6, 48, floor);
+    std::vector<Vertex> U;
+    std::vector<Edge> edgeVector;
+    floor.makeEdgesAndVertices(U, edgeVector);
+    FloorGraph graph(U, edgeVector);
+    uint64_t mapPrint = graph.fingerprint();
+    std::string fileName = "/tmp/coffeeRobot-" + std::to_string(getpid()) + ".dst";
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    bool built = DistanceStore::build(graph, graph.getCoffeeIds(), 1, fileName);
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    std::cout << "\n" << graph.getVertexCount() << " vertices, " << graph.getCoffeeIds().size() << " coffee stations, store ";
+    std::cout << (built ? "built" : "not built") << " in " << std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count() << " ms.";
+    if (!built)
+        return;
+
+    // each process: open, first answer, then queries checked against Dijkstra
+
+    const int PROCESSES = 3;
+    const int QUERIES = 200;
+    int pipeFds [2];
+    if (pipe(pipeFds) != 0)
+        return;
+    std::cout.flush();
+    std::vector<pid_t> children;
+    for (int p = 0; p < PROCESSES; p++)
+    {
+        pid_t child = fork();
+        if (child == 0)
+        {
+            ::close(pipeFds[0]);
+            std::chrono::steady_clock::time_point c0 = std::chrono::steady_clock::now();
+            DistanceStore store;
+            std::vector<int> route;
+            int mismatches = 0;
+            FloorGenerator queries(100 + p);
+            bool opened = store.open(fileName, mapPrint, false);
+            int first = opened ? store.coffeeRoute(graph, queries.below(graph.getVertexCount()), queries.below(graph.getVertexCount()), route) : -1;
+            std::chrono::steady_clock::time_point c1 = std::chrono::steady_clock::now();
+            DijkstraPlanner dijkstra(graph);
+            std::vector<int> expected;
+            for (int q = 0; opened && q < QUERIES; q++)
+            {
+                int start = queries.below(graph.getVertexCount());
+                int goal = queries.below(graph.getVertexCount());
+                int length = store.coffeeRoute(graph, start, goal, route);
+                if (q < 10 && dijkstra.coffeeRoute(start, goal, expected) != length)
+                    mismatches++;
+                if (length >= 0 && ((int) route.size() != length + 1 || route.front() != start || route.back() != goal))
+                    mismatches++;
+            }
+            std::string line = "\nProcess " + std::to_string(p + 1) + ": " + (opened ? "first answer " : "open failed ");
+            line += std::to_string(first) + " after " + std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(c1 - c0).count());
+            line += " us, " + std::to_string(mismatches) + " mismatches.";
+            ssize_t rc = write(pipeFds[1], line.data(), line.size());
+            (void) rc;
+            _exit(0);
+        }
+        children.push_back(child);
+        waitpid(child, nullptr, 0);
+    }
+    ::close(pipeFds[1]);
+    char buffer [512];
+    ssize_t got;
+    while ((got = read(pipeFds[0], buffer, sizeof(buffer))) > 0)
+        std::cout.write(buffer, got);
+    ::close(pipeFds[0]);
+
+    // swap in generation 2 under an open reader
+
+    DistanceStore reader;
+    reader.open(fileName, mapPrint, true);
+    uint64_t before = reader.getGeneration();
+    DistanceStore::build(graph, graph.getCoffeeIds(), 2, fileName);
+    reader.refresh();
+    std::cout << "\nReader moved from generation " << before << " to " << reader.getGeneration() << ".";
+
+    // a flipped bit in a block is caught by the block checksum
+
+    std::string damaged = fileName + ".bad";
+    {
+        std::vector<char> bytes(reader.getFileBytes());
+        std::FILE * in = std::fopen(fileName.c_str(), "rb");
+        size_t n = (in != nullptr) ? std::fread(bytes.data(), 1, bytes.size(), in) : 0;
+        if (in != nullptr)
+            std::fclose(in);
+        bytes[n - 1] ^= 1;
+        std::FILE * out = std::fopen(damaged.c_str(), "wb");
+        if (out != nullptr)
+        {
+            std::fwrite(bytes.data(), 1, n, out);
+            std::fclose(out);
+        }
+    }
+    DistanceStore check;
+    std::cout << "\nDamaged copy " << (check.open(damaged, mapPrint, true) ? "accepted." : "refused.");
+    std::remove(damaged.c_str());
+    std::remove(fileName.c_str());
+}
+
+#endif /* distanceStore_h */
@@ -0,0 +1,250 @@
+//  floorGenerator.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Seedable synthetic floor plans for scaling and stress runs.
+
+#ifndef floorGenerator_h
+#define floorGenerator_h
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "floorGraph.h"
+#include "floorMap.h"
+
+// the random stream is splitmix64 and bounded draws use a multiply-shift, so a
+// (layout, width, height, coffee count, seed) tuple gives the same floor on any
+// platform and standard library
+//   rooms      square rooms on a grid, each with a door to its right and lower neighbour
+//   maze       perfect maze on odd cells (iterative backtracker), one route between any two cells
+//   open       open plan with obstaclePercent of the cells walled at random
+//   corridors  long corridors joined at alternating ends, with a few random cross gaps
+
+class FloorGenerator
+{
+    private: // data elements
+        uint64_t state;
+
+    public:
+        FloorGenerator(uint64_t);
+
+    public: // random stream
+        uint64_t nextRandom();
+        int below(int);
+
+    public: // layouts
+        FloorMap rooms(int, int, int, int);
+        FloorMap maze(int, int, int);
+        FloorMap openPlan(int, int, int, int);
+        FloorMap corridors(int, int, int, int);
+        void placeCoffee(FloorMap &, int);
+
+    public: // by name, with a fresh stream
+        static bool generate(const std::string &, int, int, int, uint64_t, FloorMap &);
+};
+
+FloorGenerator::FloorGenerator(uint64_t seed)
+{
+    this -> state = seed;
+}
+
+uint64_t FloorGenerator::nextRandom()
+{
+    uint64_t z = (this -> state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// uniform in [0, n), n > 0
+
+int FloorGenerator::below(int n)
+{
+    return (int) (((nextRandom() >> 32) * (uint64_t) n) >> 32);
+}
+
+FloorMap FloorGenerator::rooms(int w, int h, int roomSize, int coffee)
+{
+    FloorMap rv(w, h);
+    int r = std::max(3, roomSize);
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+            if (x % r == r - 1 || y % r == r - 1)
+                rv.setCell(x, y, '#');
+    for (int ry = 0; ry * r < h; ry++)
+        for (int rx = 0; rx * r < w; rx++)
+        {
+            rv.setCell(rx * r + r - 1, ry * r + below(r - 1), '.');
+            rv.setCell(rx * r + below(r - 1), ry * r + r - 1, '.');
+        }
+    placeCoffee(rv, coffee);
+    return rv;
+}
+
+FloorMap FloorGenerator::maze(int w, int h, int coffee)
+{
+    FloorMap rv(w, h);
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+            rv.setCell(x, y, '#');
+
+    // cells are the (even x, even y) squares; a wall square between two cells is carved when they are joined
+
+    int cw = (w + 1) / 2;
+    int ch = (h + 1) / 2;
+    if (cw < 1 || ch < 1)
+        return rv;
+    const int dx [4] = { 1, -1, 0, 0 };
+    const int dy [4] = { 0, 0, 1, -1 };
+    std::vector<int> stack(1, 0);
+    rv.setCell(0, 0, '.');
+    while (!stack.empty())
+    {
+        int cx = stack.back() % cw;
+        int cy = stack.back() / cw;
+        int options [4];
+        int count = 0;
+        for (int d = 0; d < 4; d++)
+        {
+            int nx = cx + dx[d];
+            int ny = cy + dy[d];
+            if (nx >= 0 && ny >= 0 && nx < cw && ny < ch && !rv.isOpen(2 * nx, 2 * ny))
+                options[count++] = d;
+        }
+        if (count == 0)
+        {
+            stack.pop_back();
+            continue;
+        }
+        int d = options[below(count)];
+        rv.setCell(2 * cx + dx[d], 2 * cy + dy[d], '.');
+        rv.setCell(2 * (cx + dx[d]), 2 * (cy + dy[d]), '.');
+        stack.push_back((cy + dy[d]) * cw + cx + dx[d]);
+    }
+    placeCoffee(rv, coffee);
+    return rv;
+}
+
+FloorMap FloorGenerator::openPlan(int w, int h, int obstaclePercent, int coffee)
+{
+    FloorMap rv(w, h);
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+            if (below(100) < obstaclePercent)
+                rv.setCell(x, y, '#');
+    placeCoffee(rv, coffee);
+    return rv;
+}
+
+FloorMap FloorGenerator::corridors(int w, int h, int spacing, int coffee)
+{
+    FloorMap rv(w, h);
+    int s = std::max(2, spacing);
+    for (int y = s; y < h; y += s)
+    {
+        for (int x = 0; x < w; x++)
+            rv.setCell(x, y, '#');
+        int row = y / s;
+        rv.setCell((row % 2 == 1) ? w - 1 : 0, y, '.');
+        for (int gap = below(3); gap > 0; gap--)
+            rv.setCell(below(w), y, '.');
+    }
+    placeCoffee(rv, coffee);
+    return rv;
+}
+
+// turns count open cells into coffee stations; random probes first, then a scan
+// from a random cell if the floor is mostly wall
+
+void FloorGenerator::placeCoffee(FloorMap & map, int count)
+{
+    int w = map.getWidth();
+    int h = map.getHeight();
+    if (w < 1 || h < 1)
+        return;
+    int placed = 0;
+    for (long long attempt = 0; placed < count && attempt < 64LL * count; attempt++)
+    {
+        int x = below(w);
+        int y = below(h);
+        if (map.isOpen(x, y) && !map.isCoffee(x, y))
+        {
+            map.setCell(x, y, 'C');
+            placed++;
+        }
+    }
+    long long cells = (long long) w * h;
+    long long first = (long long) below(h) * w + below(w);
+    for (long long i = 0; placed < count && i < cells; i++)
+    {
+        long long c = (first + i) % cells;
+        int x = (int) (c % w);
+        int y = (int) (c / w);
+        if (map.isOpen(x, y) && !map.isCoffee(x, y))
+        {
+            map.setCell(x, y, 'C');
+            placed++;
+        }
+    }
+}
+
+// layout is rooms, maze, open or corridors; returns false for an unknown layout
+
+bool FloorGenerator::generate(const std::string & layout, int w, int h, int coffee, uint64_t seed, FloorMap & out)
+{
+    FloorGenerator generator(seed);
+    if (layout == "rooms")
+        out = generator.rooms(w, h, 12, coffee);
+    else if (layout == "maze")
+        out = generator.maze(w, h, coffee);
+    else if (layout == "open")
+        out = generator.openPlan(w, h, 20, coffee);
+    else if (layout == "corridors")
+        out = generator.corridors(w, h, 4, coffee);
+    else
+        return false;
+    return true;
+}
+
+// with no layout: print one small floor of each kind
+// otherwise: generate the floor, write it to fileName (if given) and report its graph size
+
+void runFloorGenerator(const std::string & layout, int w, int h, int coffee, uint64_t seed, const std::string & fileName)
+{
+    std::cout << "Floor generator will start.";
+    if (layout.empty())
+    {
+        const char * layouts [4] = { "rooms", "maze", "open", "corridors" };
+        for (int i = 0; i < 4; i++)
+        {
+            FloorMap floor;
+            FloorGenerator::generate(layouts[i], 36, 13, 2, 2021, floor);
+            std::cout << "\n" << layouts[i] << ":";
+            floor.printMap();
+        }
+        return;
+    }
+
+    FloorMap floor;
+    if (!FloorGenerator::generate(layout, w, h, coffee, seed, floor))
+    {
+        std::cout << "\nUnknown layout " << layout << " (rooms, maze, open or corridors).";
+        return;
+    }
+    if (!fileName.empty())
+    {
+        if (floor.save(fileName))
+            std::cout << "\nFloor written to " << fileName << ".";
+        else
+            std::cout << "\nFloor could not be written to " << fileName << ".";
+        return;
+    }
+    std::vector<Vertex> U;
+    std::vector<Edge> edgeVector;
+    floor.makeEdgesAndVertices(U, edgeVector);
+    FloorGraph graph(U, edgeVector);
+    std::cout << "\n" << layout << " " << w << " x " << h << ", seed " << seed << ": ";
+    std::cout << graph.getVertexCount() << " vertices, " << graph.getEdgeCount() << " directed edges, ";
+    std::cout << graph.getCoffeeIds().size() << " coffee stations, fingerprint " << graph.fingerprint() << ".";
+}
+
+#endif /* floorGenerator_h */
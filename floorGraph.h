@@ -0,0 +1,394 @@
+//  floorGraph.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Indexed view of the U and edgeVector vectors for fast searches.
+
+#ifndef floorGraph_h
+#define floorGraph_h
+#include <cstdint>
+#include <vector>
+#include "graphSolution.h"
+
+// vertex ids are positions in U
+// neighbours of vertex v are targets[offsets[v]] .. targets[offsets[v + 1] - 1]
+
+class FloorGraph
+{
+    friend class ParallelGraphBuilder;
+
+    private: // data elements
+        std::vector<Vertex> vertices;
+        std::vector<int> offsets;
+        std::vector<int> targets;
+        std::vector<int> weights;
+        std::vector<int> cells;
+        int maxWeight;
+        int minX;
+        int minY;
+        int width;
+        int height;
+
+    public:
+        FloorGraph(); // default constructor
+        FloorGraph(const std::vector<Vertex> &, const std::vector<Edge> &);
+
+    public: // accessors
+        int getVertexCount() const;
+        int getEdgeCount() const;
+        const Vertex & getVertex(int) const;
+        int getFirstEdge(int) const;
+        int getLastEdge(int) const;
+        int getTarget(int) const;
+        int getWeight(int) const;
+        int getMaxWeight() const;
+        bool isWeighted() const;
+        std::vector<int> getCoffeeIds() const;
+        int getMinX() const;
+        int getMinY() const;
+        int getWidth() const;
+        int getHeight() const;
+        uint64_t fingerprint() const;
+
+    public: // mutators
+        bool setEdgeWeight(int, int, int);
+        bool renumber(const std::vector<int> &);
+
+    public: // find
+        int findId(int, int) const;
+        int findId(const Vertex &) const;
+
+    public: // search
+        int bfs(int, std::vector<int> &, std::vector<int> &) const;
+        static void tracePath(int, int, const std::vector<int> &, std::vector<int> &);
+
+    public: // print to console
+        void printRoute(const std::vector<int> &) const;
+};
+
+FloorGraph::FloorGraph()
+{
+    this -> minX = 0;
+    this -> minY = 0;
+    this -> width = 0;
+    this -> height = 0;
+    this -> maxWeight = 1;
+    this -> offsets.push_back(0);
+}
+
+FloorGraph::FloorGraph(const std::vector<Vertex> & U, const std::vector<Edge> & edgeVector)
+{
+    this -> vertices = U;
+    this -> minX = 0;
+    this -> minY = 0;
+    this -> width = 0;
+    this -> height = 0;
+    this -> maxWeight = 1;
+
+    // bounding box of the floor, used for the (x, y) -> id lookup table
+
+    if (U.size() > 0)
+    {
+        int maxX = U[0].getX();
+        int maxY = U[0].getY();
+        this -> minX = maxX;
+        this -> minY = maxY;
+        for (size_t i = 1; i < U.size(); i++)
+        {
+            this -> minX = std::min(this -> minX, U[i].getX());
+            this -> minY = std::min(this -> minY, U[i].getY());
+            maxX = std::max(maxX, U[i].getX());
+            maxY = std::max(maxY, U[i].getY());
+        }
+        this -> width = maxX - this -> minX + 1;
+        this -> height = maxY - this -> minY + 1;
+    }
+
+    this -> cells.assign((size_t) this -> width * this -> height, -1);
+    for (size_t i = 0; i < U.size(); i++)
+        this -> cells[(size_t) (U[i].getY() - this -> minY) * this -> width + (U[i].getX() - this -> minX)] = (int) i;
+
+    // counting pass, then fill pass (edges are stored in both directions already)
+
+    int vCount = (int) U.size();
+    std::vector<int> from;
+    std::vector<int> to;
+    std::vector<int> w;
+    from.reserve(edgeVector.size());
+    to.reserve(edgeVector.size());
+    w.reserve(edgeVector.size());
+    this -> offsets.assign(vCount + 1, 0);
+    for (size_t e = 0; e < edgeVector.size(); e++)
+    {
+        int u = findId(edgeVector[e].getU());
+        int v = findId(edgeVector[e].getV());
+        if (u < 0 || v < 0)
+            continue;
+        from.push_back(u);
+        to.push_back(v);
+        w.push_back(std::max(1, edgeVector[e].getW()));
+        this -> maxWeight = std::max(this -> maxWeight, w.back());
+        this -> offsets[u + 1]++;
+    }
+    for (int v = 0; v < vCount; v++)
+        this -> offsets[v + 1] += this -> offsets[v];
+
+    this -> targets.assign(from.size(), -1);
+    this -> weights.assign(from.size(), 1);
+    std::vector<int> next(this -> offsets.begin(), this -> offsets.end() - 1);
+    for (size_t e = 0; e < from.size(); e++)
+    {
+        this -> weights[next[from[e]]] = w[e];
+        this -> targets[next[from[e]]++] = to[e];
+    }
+}
+
+int FloorGraph::getVertexCount() const
+{
+    return (int) this -> vertices.size();
+}
+
+int FloorGraph::getEdgeCount() const
+{
+    return (int) this -> targets.size();
+}
+
+const Vertex & FloorGraph::getVertex(int id) const
+{
+    return this -> vertices[id];
+}
+
+int FloorGraph::getFirstEdge(int id) const
+{
+    return this -> offsets[id];
+}
+
+int FloorGraph::getLastEdge(int id) const
+{
+    return this -> offsets[id + 1];
+}
+
+int FloorGraph::getTarget(int e) const
+{
+    return this -> targets[e];
+}
+
+int FloorGraph::getWeight(int e) const
+{
+    return this -> weights[e];
+}
+
+int FloorGraph::getMaxWeight() const
+{
+    return this -> maxWeight;
+}
+
+bool FloorGraph::isWeighted() const
+{
+    return this -> maxWeight > 1;
+}
+
+std::vector<int> FloorGraph::getCoffeeIds() const
+{
+    std::vector<int> rv;
+    for (size_t i = 0; i < this -> vertices.size(); i++)
+        if (this -> vertices[i].getC())
+            rv.push_back((int) i);
+    return rv;
+}
+
+int FloorGraph::getMinX() const
+{
+    return this -> minX;
+}
+
+int FloorGraph::getMinY() const
+{
+    return this -> minY;
+}
+
+int FloorGraph::getWidth() const
+{
+    return this -> width;
+}
+
+int FloorGraph::getHeight() const
+{
+    return this -> height;
+}
+
+// FNV-1a over vertices, coffee flags, adjacency and weights
+// tables precomputed for one map are checked against it before use
+
+uint64_t FloorGraph::fingerprint() const
+{
+    uint64_t rv = 1469598103934665603ULL;
+    auto mix = [&rv](long long value)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            rv ^= (uint64_t) ((value >> (8 * i)) & 0xff);
+            rv *= 1099511628211ULL;
+        }
+    };
+    for (size_t i = 0; i < this -> vertices.size(); i++)
+    {
+        mix(this -> vertices[i].getX());
+        mix(this -> vertices[i].getY());
+        mix(this -> vertices[i].getC());
+    }
+    for (size_t i = 0; i < this -> offsets.size(); i++)
+        mix(this -> offsets[i]);
+    for (size_t e = 0; e < this -> targets.size(); e++)
+    {
+        mix(this -> targets[e]);
+        mix(this -> weights[e]);
+    }
+    return rv;
+}
+
+// set the weight of u -- v in both directions (weights below 1 are raised to 1)
+// returns false if there is no such edge
+
+bool FloorGraph::setEdgeWeight(int u, int v, int weight)
+{
+    bool rv = false;
+    weight = std::max(1, weight);
+    for (int e = this -> offsets[u]; e < this -> offsets[u + 1]; e++)
+        if (this -> targets[e] == v)
+        {
+            this -> weights[e] = weight;
+            rv = true;
+        }
+    for (int e = this -> offsets[v]; e < this -> offsets[v + 1]; e++)
+        if (this -> targets[e] == u)
+            this -> weights[e] = weight;
+    if (rv)
+        this -> maxWeight = std::max(this -> maxWeight, weight);
+    return rv;
+}
+
+// vertex v becomes vertex newIds[v]; adjacency, weights and the (x, y) -> id
+// table are rebuilt to match, each vertex keeping its neighbour order
+// returns false (and changes nothing) unless newIds is a permutation of the ids
+
+bool FloorGraph::renumber(const std::vector<int> & newIds)
+{
+    int vCount = getVertexCount();
+    if ((int) newIds.size() != vCount)
+        return false;
+    std::vector<int> oldIds(vCount, -1);
+    for (int v = 0; v < vCount; v++)
+    {
+        if (newIds[v] < 0 || newIds[v] >= vCount || oldIds[newIds[v]] >= 0)
+            return false;
+        oldIds[newIds[v]] = v;
+    }
+
+    std::vector<Vertex> vertices2(vCount);
+    std::vector<int> offsets2(vCount + 1, 0);
+    std::vector<int> targets2(this -> targets.size());
+    std::vector<int> weights2(this -> weights.size());
+    for (int n = 0; n < vCount; n++)
+    {
+        int v = oldIds[n];
+        vertices2[n] = this -> vertices[v];
+        offsets2[n + 1] = offsets2[n] + (this -> offsets[v + 1] - this -> offsets[v]);
+        for (int e = this -> offsets[v], k = offsets2[n]; e < this -> offsets[v + 1]; e++, k++)
+        {
+            targets2[k] = newIds[this -> targets[e]];
+            weights2[k] = this -> weights[e];
+        }
+    }
+    for (size_t c = 0; c < this -> cells.size(); c++)
+        if (this -> cells[c] >= 0)
+            this -> cells[c] = newIds[this -> cells[c]];
+
+    this -> vertices.swap(vertices2);
+    this -> offsets.swap(offsets2);
+    this -> targets.swap(targets2);
+    this -> weights.swap(weights2);
+    return true;
+}
+
+int FloorGraph::findId(int x, int y) const
+{
+    int cx = x - this -> minX;
+    int cy = y - this -> minY;
+    if (cx < 0 || cy < 0 || cx >= this -> width || cy >= this -> height)
+        return -1;
+    return this -> cells[(size_t) cy * this -> width + cx];
+}
+
+int FloorGraph::findId(const Vertex & target) const
+{
+    return findId(target.getX(), target.getY());
+}
+
+// breadth first search from source, ignoring weights
+// dist[v] is the number of edges to v (-1 if unreachable), parent[v] the previous vertex
+// returns the number of vertices reached
+
+int FloorGraph::bfs(int source, std::vector<int> & dist, std::vector<int> & parent) const
+{
+    int vCount = getVertexCount();
+    dist.assign(vCount, -1);
+    parent.assign(vCount, -1);
+    if (source < 0 || source >= vCount)
+        return 0;
+
+    std::vector<int> queue;
+    queue.reserve(vCount);
+    queue.push_back(source);
+    dist[source] = 0;
+    for (size_t head = 0; head < queue.size(); head++)
+    {
+        int u = queue[head];
+        for (int e = this -> offsets[u]; e < this -> offsets[u + 1]; e++)
+        {
+            int v = this -> targets[e];
+            if (dist[v] < 0)
+            {
+                dist[v] = dist[u] + 1;
+                parent[v] = u;
+                queue.push_back(v);
+            }
+        }
+    }
+    return (int) queue.size();
+}
+
+// append the route source -> target (both inclusive) recorded in a parent tree
+
+void FloorGraph::tracePath(int source, int target, const std::vector<int> & parent, std::vector<int> & route)
+{
+    std::vector<int> reversed;
+    for (int v = target; v >= 0; v = parent[v])
+    {
+        reversed.push_back(v);
+        if (v == source)
+            break;
+    }
+    if (reversed.empty() || reversed.back() != source)
+        return;
+    route.insert(route.end(), reversed.rbegin(), reversed.rend());
+}
+
+void FloorGraph::printRoute(const std::vector<int> & route) const
+{
+    std::cout << "\n{ ";
+    if (route.size() > 0)
+    {
+        for (size_t i = 0; i < route.size(); i++)
+        {
+            Vertex v = this -> vertices[route[i]];
+            v.printVertex();
+            if (i + 1 < route.size())
+                std::cout << ", ";
+        }
+    } else {
+        std::cout << "empty";
+    }
+    std::cout << " }";
+}
+
+#endif /* floorGraph_h */
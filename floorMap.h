@@ -0,0 +1,228 @@
+//  floorMap.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Text floor maps: one line per row, one character per cell.
+
+#ifndef floorMap_h
+#define floorMap_h
+#include <fstream>
+#include <string>
+#include <vector>
+#include "graphSolution.h"
+
+// '#'        wall (no vertex)
+// '.'        floor, cost 1
+// '1' .. '9' floor with a travel cost (carpet, ramp, door)
+// 'C'        coffee station, cost 1
+// line y of the file is row y; character x of the line is column x
+// an edge costs the larger of the two cell costs, so both directions agree
+
+class FloorMap
+{
+    private: // data elements
+        int width;
+        int height;
+        std::vector<char> cells;
+
+    public:
+        FloorMap(); // default constructor
+        FloorMap(int, int);
+
+    public: // accessors
+        int getWidth() const;
+        int getHeight() const;
+        char getCell(int, int) const;
+        bool isOpen(int, int) const;
+        bool isCoffee(int, int) const;
+        int getCost(int, int) const;
+
+    public: // mutators
+        void setCell(int, int, char);
+
+    public: // files
+        bool read(std::istream &);
+        void write(std::ostream &) const;
+        bool load(const std::string &);
+        bool save(const std::string &) const;
+
+    public: // onboarding into U and edgeVector (columns left to right, like the demo map)
+        void makeEdgesAndVertices(std::vector<Vertex> &, std::vector<Edge> &) const;
+
+    public: // built-in maps
+        static FloorMap demoFloor();
+
+    public: // print to console
+        void printMap() const;
+};
+
+FloorMap::FloorMap()
+{
+    this -> width = 0;
+    this -> height = 0;
+}
+
+FloorMap::FloorMap(int w, int h)
+{
+    this -> width = w;
+    this -> height = h;
+    this -> cells.assign((size_t) w * h, '.');
+}
+
+int FloorMap::getWidth() const
+{
+    return this -> width;
+}
+
+int FloorMap::getHeight() const
+{
+    return this -> height;
+}
+
+char FloorMap::getCell(int x, int y) const
+{
+    if (x < 0 || y < 0 || x >= this -> width || y >= this -> height)
+        return '#';
+    return this -> cells[(size_t) y * this -> width + x];
+}
+
+bool FloorMap::isOpen(int x, int y) const
+{
+    char c = getCell(x, y);
+    return c == '.' || c == 'C' || (c >= '1' && c <= '9');
+}
+
+bool FloorMap::isCoffee(int x, int y) const
+{
+    return getCell(x, y) == 'C';
+}
+
+int FloorMap::getCost(int x, int y) const
+{
+    char c = getCell(x, y);
+    if (c >= '1' && c <= '9')
+        return c - '0';
+    return 1;
+}
+
+void FloorMap::setCell(int x, int y, char c)
+{
+    if (x < 0 || y < 0 || x >= this -> width || y >= this -> height)
+        return;
+    this -> cells[(size_t) y * this -> width + x] = c;
+}
+
+// rows shorter than the widest row are padded with walls
+
+bool FloorMap::read(std::istream & in)
+{
+    std::vector<std::string> rows;
+    std::string line;
+    size_t w = 0;
+    while (std::getline(in, line))
+    {
+        if (line.size() > 0 && line[line.size() - 1] == '\r')
+            line.erase(line.size() - 1);
+        rows.push_back(line);
+        w = std::max(w, line.size());
+    }
+    while (rows.size() > 0 && rows.back().empty())
+        rows.pop_back();
+    if (rows.empty())
+        return false;
+
+    this -> width = (int) w;
+    this -> height = (int) rows.size();
+    this -> cells.assign(w * rows.size(), '#');
+    for (size_t y = 0; y < rows.size(); y++)
+        for (size_t x = 0; x < rows[y].size(); x++)
+            this -> cells[y * w + x] = rows[y][x];
+    return true;
+}
+
+void FloorMap::write(std::ostream & out) const
+{
+    for (int y = 0; y < this -> height; y++)
+    {
+        out.write(&(this -> cells[(size_t) y * this -> width]), this -> width);
+        out << '\n';
+    }
+}
+
+bool FloorMap::load(const std::string & fileName)
+{
+    std::ifstream in(fileName.c_str());
+    if (!in)
+        return false;
+    return read(in);
+}
+
+bool FloorMap::save(const std::string & fileName) const
+{
+    std::ofstream out(fileName.c_str());
+    if (!out)
+        return false;
+    write(out);
+    return (bool) out;
+}
+
+void FloorMap::makeEdgesAndVertices(std::vector<Vertex> & U, std::vector<Edge> & edgeVector) const
+{
+    Edge pair [2];
+    for (int x = 0; x < this -> width; x++)
+        for (int y = 0; y < this -> height; y++)
+        {
+            if (!isOpen(x, y))
+                continue;
+            Vertex v;
+            v.setXY(x, y);
+            if (isCoffee(x, y))
+                v.placeC();
+            U.push_back(v);
+
+            if (isOpen(x - 1, y))
+            {
+                Vertex left;
+                left.setXY(x - 1, y);
+                if (isCoffee(x - 1, y))
+                    left.placeC();
+                Edge::addEdgePair(pair, edgeVector, v, left, std::max(getCost(x, y), getCost(x - 1, y)));
+            }
+            if (isOpen(x, y - 1))
+            {
+                Vertex down;
+                down.setXY(x, y - 1);
+                if (isCoffee(x, y - 1))
+                    down.placeC();
+                Edge::addEdgePair(pair, edgeVector, v, down, std::max(getCost(x, y), getCost(x, y - 1)));
+            }
+        }
+}
+
+// the floor built by Edge::makeEdgesAndVertices
+
+FloorMap FloorMap::demoFloor()
+{
+    const char * rows [6] = { "C...C....",
+                              ".#.......",
+                              ".#.......",
+                              ".#####...",
+                              ".#...#.C.",
+                              "........." };
+    FloorMap rv(9, 6);
+    for (int y = 0; y < 6; y++)
+        for (int x = 0; x < 9; x++)
+            rv.setCell(x, y, rows[y][x]);
+    return rv;
+}
+
+void FloorMap::printMap() const
+{
+    std::cout << "\nFloor map " << this -> width << " x " << this -> height << ":";
+    for (int y = 0; y < this -> height; y++)
+    {
+        std::cout << "\n  ";
+        std::cout.write(&(this -> cells[(size_t) y * this -> width]), this -> width);
+    }
+}
+
+#endif /* floorMap_h */
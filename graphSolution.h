@@ -6,10 +6,54 @@
 
 #ifndef graphSolution_h
 #define graphSolution_h
+#include <algorithm>
+#include <functional>
+#include <iostream>
 #include <vector>
+#include "searchLimit.h"
 
 class Edge;
 
+// optional search counters, filled in only while activeCounters is set
+// (SearchMetrics in searchMetrics.h points it at its own); one per thread, so
+// concurrent planners never count into each other's record
+
+struct SearchCounters
+{
+    long long pathsGenerated;
+    long long duplicatesRejected;
+    long long verticesExpanded;
+    long long allocations;
+    long long bytes;
+};
+
+thread_local SearchCounters * activeCounters = nullptr;
+
+void countAllocation(long long bytes)
+{
+    if (activeCounters != nullptr)
+    {
+        activeCounters -> allocations++;
+        activeCounters -> bytes += bytes;
+    }
+}
+
+void countExpansion()
+{
+    if (activeCounters != nullptr)
+        activeCounters -> verticesExpanded++;
+}
+
+void countPath(bool duplicate)
+{
+    if (activeCounters != nullptr)
+    {
+        activeCounters -> pathsGenerated++;
+        if (duplicate)
+            activeCounters -> duplicatesRejected++;
+    }
+}
+
 class Vertex
 {
     private: // data elements
@@ -154,14 +198,17 @@ class Edge : public Vertex
     private: // data elements
         Vertex u;
         Vertex v;
+        int w = 1;
     
     public: // accessor
         Vertex getU() const;
         Vertex getV() const;
+        int getW() const;
     
     public: // mutator
         void setUV(Vertex, Vertex);
         void setUVfromArray(Vertex [2]);
+        void setW(int);
 
     public: // print to console
         void printEdge();
@@ -171,7 +218,7 @@ class Edge : public Vertex
         static Vertex findNeighbours(std::vector<Edge>, Vertex, std::vector<Vertex> &);
     
     public: // add edge (pairwise)
-        static void addEdgePair(Edge [2], std::vector<Edge> &, Vertex, Vertex);
+        static void addEdgePair(Edge [2], std::vector<Edge> &, Vertex, Vertex, int = 1);
     
     public: //
         static void makeEdgesAndVertices(std::vector<Vertex> &, Vertex *, std::vector<Edge> &, Edge *, int, int);
@@ -187,6 +234,11 @@ Vertex Edge::getV() const
     return this -> v;
 }
 
+int Edge::getW() const
+{
+    return this -> w;
+}
+
 void Edge::setUV(Vertex o1, Vertex o2)
 {
     this -> u = o1;
@@ -199,6 +251,13 @@ void Edge::setUVfromArray(Vertex a [2])
     this -> v = *(a+1);
 }
 
+// cost of travelling the edge, 1 unless the map says otherwise
+
+void Edge::setW(int n)
+{
+    this -> w = n;
+}
+
 void Edge::printEdge()
 {
     std::cout << "{ ";
@@ -246,10 +305,12 @@ void Vertex::printNeighbours(std::vector<Edge> edgeVector)
     }
 }
 
-void Edge::addEdgePair(Edge pair [2], std::vector<Edge> & vec, Vertex left, Vertex right)
+void Edge::addEdgePair(Edge pair [2], std::vector<Edge> & vec, Vertex left, Vertex right, int weight)
 {
     (pair) -> setUV(left, right);
     (pair + 1) -> setUV(right, left);
+    (pair) -> setW(weight);
+    (pair + 1) -> setW(weight);
     vec.push_back(*pair);
     vec.push_back(*(pair + 1));
 }
@@ -320,6 +381,7 @@ class Path
     public:
         Path();
         Path(const Path &);
+        Path(const Vertex *, int);
         ~Path();
     
     public:
@@ -360,6 +422,7 @@ Path::Path()
     this -> pConsoleDetail = false;
     
     this -> path = new Vertex [this -> capacity];
+    countAllocation(this -> capacity * (long long) sizeof(Vertex));
 
     if (this -> pConsoleDetail)
         std::cout << "\nDefault constructor for a Path object has run.";
@@ -373,6 +436,7 @@ Path::Path(const Path & right)
     this -> pConsoleDetail = right.pConsoleDetail;
     
     this -> path = new Vertex[this -> capacity];
+    countAllocation(this -> capacity * (long long) sizeof(Vertex));
     if (right.size > 0)
         for (int i = 0; i < right.size; i++)
             *(this -> path + i) = *(right.path + i);
@@ -381,6 +445,27 @@ Path::Path(const Path & right)
         std::cout << "\nCopy constructor for a Path object has run.";
 }
 
+// build a path from a vertex array without per-vertex console output
+
+Path::Path(const Vertex * vertices, int count)
+{
+    this -> capacity = 15;
+    while (count >= this -> capacity - 2)
+        this -> capacity *= 2;
+    this -> size = count;
+    this -> hasCoffee = false;
+    this -> pConsoleDetail = false;
+
+    this -> path = new Vertex [this -> capacity];
+    countAllocation(this -> capacity * (long long) sizeof(Vertex));
+    for (int i = 0; i < count; i++)
+    {
+        *(this -> path + i) = *(vertices + i);
+        if ((vertices + i) -> getC())
+            this -> hasCoffee = true;
+    }
+}
+
 Path::~Path()
 {
     if (this -> pConsoleDetail)
@@ -418,6 +503,7 @@ void Path::verifyCapacity()
         this -> capacity *= 2;
         
         Vertex * newPath = new Vertex [this -> capacity];
+        countAllocation(this -> capacity * (long long) sizeof(Vertex));
         
         for (int i = 0; i < this -> size; i++)
             *(newPath + i) = *(this -> path + i);
@@ -481,6 +567,7 @@ Path Path::operator=(const Path & right)
         this -> capacity = right.capacity;
         
         this -> path = new Vertex[this -> capacity];
+        countAllocation(this -> capacity * (long long) sizeof(Vertex));
         if (right.size > 0)
             for (int i = 0; i < this -> size; i++)
                 *(this -> path + i) = *(right.path + i);
@@ -567,6 +654,7 @@ class PathBook
         int bookCapacity;
         int pathSize;
         bool pbConsoleDetail;
+        bool keepCapacity; // set while refill runs, so resizeBook only grows
     
     public:
         PathBook();
@@ -595,6 +683,8 @@ class PathBook
         int findPath(Path);
         void initiatePaths(std::vector<Vertex> &, std::vector<Edge>);
         void extendFromVertex(Path, std::vector<Vertex> &, std::vector<Vertex> &, std::vector<Vertex> &, std::vector<Edge>);
+        void refill(std::vector<Vertex>, std::vector<Vertex>, std::vector<Vertex> &, const PathBook &, int, std::vector<Edge>);
+        void swapBook(PathBook &);
         void printBook();
 };
 
@@ -603,7 +693,9 @@ PathBook::PathBook()
     this -> bookSize = 0;
     this -> bookCapacity = 10;
     this -> book = new Path[this -> bookCapacity];
+    countAllocation(this -> bookCapacity * (long long) sizeof(Path));
     this -> pbConsoleDetail = false;
+    this -> keepCapacity = false;
     
     if (this -> pbConsoleDetail)
         std::cout << "\nPathBook default constructor has run.";
@@ -615,7 +707,9 @@ PathBook::PathBook(Vertex x)
     this -> bookSize = 0;
     this -> bookCapacity = 10;
     this -> book = new Path[this -> bookCapacity];
+    countAllocation(this -> bookCapacity * (long long) sizeof(Path));
     this -> pbConsoleDetail = false;
+    this -> keepCapacity = false;
     
     if (this -> pbConsoleDetail)
         std::cout << "\nPathBook 1 arg constructor has run.";
@@ -627,7 +721,9 @@ PathBook::PathBook(const PathBook & right)
     this -> bookSize = right.bookSize;
     this -> bookCapacity = right.bookCapacity;
     this -> pbConsoleDetail = right.pbConsoleDetail;
+    this -> keepCapacity = false;
     this -> book = new Path[right.bookCapacity];
+    countAllocation(right.bookCapacity * (long long) sizeof(Path));
     
     if (right.bookSize > 0)
         for (int i = 0; i < right.bookSize; i++)
@@ -648,11 +744,13 @@ PathBook::PathBook(std::vector<Vertex> fr, std::vector<Vertex> ex, std::vector<V
     if (startPathBookObj.bookSize < 1)
         checksum--;
     int bSize = 0;
+    this -> keepCapacity = false;
     if (checksum != 0)
     {
         this -> bookSize = 0;
         this -> bookCapacity = 10;
         this -> book = new Path[this -> bookCapacity];
+        countAllocation(this -> bookCapacity * (long long) sizeof(Path));
         this -> pbConsoleDetail = false;
 
         std::cout << "\nPathBook 6 arg constructor cannot run.";
@@ -663,6 +761,7 @@ PathBook::PathBook(std::vector<Vertex> fr, std::vector<Vertex> ex, std::vector<V
         this -> start = startPathBookObj.start;
         this -> bookCapacity = 3 * (startPathBookObj.bookSize);
         this -> book = new Path[this -> bookCapacity];
+        countAllocation(this -> bookCapacity * (long long) sizeof(Path));
         this -> bookSize = 0;
         this -> pbConsoleDetail = false;
         
@@ -723,6 +822,7 @@ PathBook PathBook::operator=(const PathBook & right)
         this -> bookSize = right.bookSize;
         this -> bookCapacity = right.bookCapacity;
         this -> book = new Path[right.bookCapacity];
+        countAllocation(right.bookCapacity * (long long) sizeof(Path));
         
         if (right.bookSize > 0)
             for (int i = 0; i < right.bookSize; i++)
@@ -754,6 +854,7 @@ void PathBook::resizeBook()
         this -> bookCapacity *= 2;
         
         Path * newBook = new Path [this -> bookCapacity];
+        countAllocation(this -> bookCapacity * (long long) sizeof(Path));
         for (int i = 0; i < this -> bookSize; i++)
             *(newBook + i) = *(this -> book + i);
         
@@ -764,11 +865,12 @@ void PathBook::resizeBook()
         std::cout << "\nPathBook object capacity increased to " << this -> bookCapacity << ".";
     }
     else if (this -> bookSize < (this -> bookCapacity / 3) &&
-             this -> bookCapacity > 400)
+             this -> bookCapacity > 400 && !this -> keepCapacity)
     {
         this -> bookCapacity /= 2;
         
         Path * newBook = new Path [this -> bookCapacity];
+        countAllocation(this -> bookCapacity * (long long) sizeof(Path));
         for (int i = 0; i < this -> bookSize; i++)
             *(newBook + i) = *(this -> book + i);
         std::cout << "\nOld PathBook object address: " << this -> book << ".";
@@ -811,15 +913,19 @@ void PathBook::initiatePaths(std::vector<Vertex> & n, std::vector<Edge> edgeVect
     std::vector<Vertex>::iterator itn;
     n.clear();
     int test = (Edge::findNeighbours(edgeVector, this -> start, n)).getX();
+    countExpansion();
     if (test >= 0)
     {
         itn = n.begin();
         for (; itn < n.end(); itn++)
         {
             Path * next = new Path;
+            countAllocation(sizeof(Path));
             next -> addVertex(this -> start);
             next -> addVertex(*itn);
-            if (findPath(*next) < 0)
+            bool duplicate = (findPath(*next) >= 0);
+            countPath(duplicate);
+            if (!duplicate)
             {
                 addPathToBook(*next);
                 std::cout << "\nMethod initiatePaths has added a path.";
@@ -841,6 +947,7 @@ void PathBook::extendFromVertex(Path startPath, std::vector<Vertex> & fr,std::ve
     std::cout << "\nPath object startPath path size: ";
     std::cout << startPath.getPathSize();
     Edge::findNeighbours(edgeVector, pivot, n).getX();
+    countExpansion();
     int test = (int) n.size();
     std::cout << "\nTest value: " << test;
     for (itn = n.end() - 1; itn >= n.begin(); itn--)
@@ -858,13 +965,16 @@ void PathBook::extendFromVertex(Path startPath, std::vector<Vertex> & fr,std::ve
         for (; itn < n.end(); itn++)
         {
             Path * next = new Path;
+            countAllocation(sizeof(Path));
             *next = startPath;
             std::cout << "\nNew path: ";
             next -> printPath();
             std::cout << "\nVertex to add: ";
             itn -> printVertex();
             next -> addVertex(*itn);
-            if (findPath(*next) < 0)
+            bool duplicate = (findPath(*next) >= 0);
+            countPath(duplicate);
+            if (!duplicate)
             {
                 addPathToBook(*next);
                 std::cout << "\nMethod extendFromVertex has added a path.";
@@ -875,6 +985,65 @@ void PathBook::extendFromVertex(Path startPath, std::vector<Vertex> & fr,std::ve
     }
 }
 
+// the 6 arg constructor, rebuilding this book in place instead of allocating a new one
+// the Path buffer is kept when it is large enough, so rolling levels reuse their storage;
+// it may grow while the level is filled but is never shrunk here
+
+void PathBook::refill(std::vector<Vertex> fr, std::vector<Vertex> ex, std::vector<Vertex> & n, const PathBook & startPathBookObj, int targetPathSize, std::vector<Edge> edgeVector)
+{
+    int checksum = 0;
+    Path * startPathPtr = startPathBookObj.getBookPtr();
+    int startPathSize = startPathBookObj.getBookSize();
+    for (int i = 0; i < startPathSize; i++)
+        if ((startPathPtr + i) -> getPathSize() != targetPathSize)
+            checksum--;
+    if (startPathBookObj.bookSize < 1)
+        checksum--;
+    this -> bookSize = 0;
+    if (checksum != 0)
+    {
+        std::cout << "\nPathBook refill cannot run.";
+        return;
+    }
+
+    this -> start = startPathBookObj.start;
+    if (this -> bookCapacity < 3 * startPathBookObj.bookSize)
+    {
+        delete [] this -> book;
+        this -> bookCapacity = 3 * startPathBookObj.bookSize;
+        this -> book = new Path[this -> bookCapacity];
+        countAllocation(this -> bookCapacity * (long long) sizeof(Path));
+    }
+
+    int bSize = 0;
+    this -> keepCapacity = true;
+    for (int k = 0; k < startPathSize; k++)
+    {
+        n.clear();
+        extendFromVertex(*(startPathPtr + k), fr, ex, n, edgeVector);
+        bSize += n.size();
+    }
+    this -> keepCapacity = false;
+
+    // slots counted but not filled hold empty paths, as in a fresh book
+
+    for (int i = this -> bookSize; i < bSize && i < this -> bookCapacity; i++)
+        *(this -> book + i) = Path();
+    this -> bookSize = bSize;
+
+    std::cout << "\nPathBook refill has run.";
+}
+
+void PathBook::swapBook(PathBook & other)
+{
+    std::swap(this -> start, other.start);
+    std::swap(this -> book, other.book);
+    std::swap(this -> bookSize, other.bookSize);
+    std::swap(this -> bookCapacity, other.bookCapacity);
+    std::swap(this -> pathSize, other.pathSize);
+    std::swap(this -> pbConsoleDetail, other.pbConsoleDetail);
+}
+
 void PathBook::printBook()
 {
     if (this -> bookSize == 0)
@@ -1085,10 +1254,16 @@ class WorkBook
     
     public:
         int getPathSizeTarget() const;
+        int levelsLeft() const;
     
     public:
         void addBook();
         void addBooks(int);
+        void addBooksRolling(int, int);
+        SearchResult addBooks(int, SearchLimit &);
+        SearchResult addBooks(int, SearchLimit &, const std::function<void(WorkBook &)> &);
+        SearchResult addBooksRolling(int, int, SearchLimit &);
+        void rollBook();
         void calibrate(int);
     
     public:
@@ -1209,6 +1384,14 @@ int WorkBook::getPathSizeTarget() const
     return this -> pathSizeTarget;
 }
 
+// levels an addBooks loop may still add: the 25 level cap, less the levels
+// already built on top of the first book
+
+int WorkBook::levelsLeft() const
+{
+    return 25 - (this -> booksCount - 1);
+}
+
 void WorkBook::addBook()
 {
     if (this -> booksCount < this -> booksBuffer - 1)
@@ -1224,16 +1407,105 @@ void WorkBook::addBook()
 
 void WorkBook::addBooks(int n)
 {
-    int m = 25;
+    SearchLimit none;
+    addBooks(n, none);
+}
+
+// the same, checking limit before each level; on expiry or cancellation the
+// books built so far are kept and the result carries the levels added
+// length is the solution's step count, or -1
+
+SearchResult WorkBook::addBooks(int n, SearchLimit & limit)
+{
+    return addBooks(n, limit, std::function<void(WorkBook &)>());
+}
+
+// afterLevel (if set) runs after every completed level, e.g. to checkpoint
+// the level cap (levelsLeft) counts the levels already in the books, so a
+// resumed search gets only the remainder
+
+SearchResult WorkBook::addBooks(int n, SearchLimit & limit, const std::function<void(WorkBook &)> & afterLevel)
+{
+    int m = levelsLeft();
     bool guard = false;
     while (m > 0 && guard == false && (this -> books + this -> booksCount - 1) -> getBookSize() > 0)
     {
+        if (limit.checkNow())
+            break;
         calibrate(n);
         addBook();
         m--;
         guard = goalFound();
+        if (afterLevel)
+            afterLevel(*this);
     }
     printBooks();
+    int length = -1;
+    if (guard)
+        length = ((this -> books + this -> booksCount - 1) -> getBookPtr() + this -> solution) -> getPathSize() - 1;
+    return limit.finish(length);
+}
+
+// rolling mode: only books[0] (the previous level) and books[1] (the current level)
+// are kept; each new level is built into the older book's buffer and the two are
+// swapped, so booksCount stays at 2 and depth is not limited by booksBuffer
+// the books array is cut down to those two before the first level
+// maxLevels <= 0 searches until the goal is found or a level comes out empty
+
+void WorkBook::addBooksRolling(int n, int maxLevels)
+{
+    SearchLimit none;
+    addBooksRolling(n, maxLevels, none);
+}
+
+SearchResult WorkBook::addBooksRolling(int n, int maxLevels, SearchLimit & limit)
+{
+    if (this -> booksBuffer > 2 && this -> booksCount <= 2)
+    {
+        PathBook * kept = new PathBook [2];
+        for (int i = 0; i < this -> booksCount; i++)
+            (kept + i) -> swapBook(*(this -> books + i));
+        delete [] this -> books;
+        this -> books = kept;
+        this -> booksBuffer = 2;
+    }
+
+    bool guard = false;
+    int levels = 0;
+    while ((maxLevels <= 0 || levels < maxLevels) && guard == false && (this -> books + this -> booksCount - 1) -> getBookSize() > 0)
+    {
+        if (limit.checkNow())
+            break;
+        calibrate(n);
+        rollBook();
+        levels++;
+        guard = goalFound();
+    }
+    printBooks();
+    int length = -1;
+    if (guard)
+        length = ((this -> books + this -> booksCount - 1) -> getBookPtr() + this -> solution) -> getPathSize() - 1;
+    return limit.finish(length);
+}
+
+// the first rolled level fills books[1]; later ones refill books[0] and swap
+
+void WorkBook::rollBook()
+{
+    if (this -> booksCount < 2)
+    {
+        (this -> books + 1) -> refill(this -> fr, this -> ex, this -> n, *(this -> books), pathSizeTarget, this -> edgeVector);
+        this -> booksCount = 2;
+    }
+    else
+    {
+        (this -> books) -> refill(this -> fr, this -> ex, this -> n, *(this -> books + 1), pathSizeTarget, this -> edgeVector);
+        (this -> books) -> swapBook(*(this -> books + 1));
+    }
+    this -> pathSizeTarget++;
+
+    std::cout << "\nWorkBook rollBook method has run.";
+    std::cout << "\nWorkBook path size target is now " << this -> pathSizeTarget << ".";
 }
 
 // update exFrontier and frontier vectors
@@ -1425,4 +1697,25 @@ void runWorkBook()
     wb.printSolution();
 }
 
+// the same search with rolling two-level storage
+
+void runWorkBookRolling()
+{
+    std::cout << "Rolling testing will start.";
+    std::vector<Vertex> U;
+    std::vector<Vertex> n;
+    std::vector<Vertex> ex;
+    std::vector<Vertex> fr;
+    std::vector<Edge> edgeVector;
+
+    const int DELAY = 2;
+
+    WorkBook wb ( 2, U, n, ex, fr, edgeVector );
+
+    wb.addBooksRolling ( DELAY, 0 );
+
+    std::cout << "\nThe current path size target is " << wb.getPathSizeTarget() << ".";
+    wb.printSolution();
+}
+
 #endif /* graphSolution_h */
@@ -0,0 +1,296 @@
+//  heuristicSearch.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  A* with pluggable lower-bound heuristics.
+
+#ifndef heuristicSearch_h
+#define heuristicSearch_h
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include "floorGraph.h"
+#include "queryOverlay.h"
+#include "searchLimit.h"
+#include "weightedSearch.h"
+
+// a heuristic returns a lower bound on the route cost between two vertices,
+// or UNREACHABLE when it can prove there is no route (A* then prunes the state)
+// bounds must be consistent (bound(u, t) <= w(u, v) + bound(v, t)) and satisfy
+// the triangle inequality, so A* can use the monotone bucket queue
+
+class Heuristic
+{
+    public:
+        static constexpr int UNREACHABLE = 1 << 29;
+
+    public:
+        virtual ~Heuristic() {}
+
+    public:
+        virtual int bound(int, int) const = 0;
+};
+
+// every step moves one cell and costs at least 1
+
+class ManhattanHeuristic : public Heuristic
+{
+    private: // data elements
+        const FloorGraph * graph;
+
+    public:
+        ManhattanHeuristic(const FloorGraph &);
+
+    public:
+        int bound(int, int) const;
+};
+
+ManhattanHeuristic::ManhattanHeuristic(const FloorGraph & g)
+{
+    this -> graph = & g;
+}
+
+int ManhattanHeuristic::bound(int u, int t) const
+{
+    const Vertex & a = this -> graph -> getVertex(u);
+    const Vertex & b = this -> graph -> getVertex(t);
+    return std::abs(a.getX() - b.getX()) + std::abs(a.getY() - b.getY());
+}
+
+// states are the same as in DijkstraPlanner: v, or v + V once coffee is carried
+// before the coffee the estimate is min over stations c of bound(v, c) + bound(c, goal)
+
+class AStarPlanner
+{
+    private: // data elements
+        const FloorGraph * graph;
+        const Heuristic * heuristic;
+        std::vector<int> coffee;
+        BucketQueue queue;
+        std::vector<int> g;
+        std::vector<int> h;
+        std::vector<int> parent;
+        std::vector<uint32_t> seen;
+        uint32_t generation;
+        int expanded;
+
+    public:
+        AStarPlanner(const FloorGraph &, const Heuristic &);
+
+    public: // accessors
+        int getExpandedCount() const;
+
+    public: // mutators
+        void setHeuristic(const Heuristic &);
+
+    public: // queries
+        int shortestPath(int, int, std::vector<int> &);
+        int coffeeRoute(int, int, std::vector<int> &);
+        int coffeeRoute(int, int, std::vector<int> &, const QueryOverlay &);
+        SearchResult shortestPath(int, int, std::vector<int> &, SearchLimit &);
+        SearchResult coffeeRoute(int, int, std::vector<int> &, SearchLimit &);
+
+    private:
+        int estimate(int, int, bool) const;
+        void touch(int);
+        int search(int, int, bool, const QueryOverlay *, SearchLimit *);
+};
+
+AStarPlanner::AStarPlanner(const FloorGraph & graphRef, const Heuristic & heuristicRef)
+{
+    this -> graph = & graphRef;
+    this -> heuristic = & heuristicRef;
+    this -> coffee = graphRef.getCoffeeIds();
+    this -> expanded = 0;
+    this -> generation = 0;
+    int states = 2 * graphRef.getVertexCount();
+    this -> g.resize(states);
+    this -> h.resize(states);
+    this -> parent.resize(states);
+    this -> seen.resize(states, 0);
+}
+
+int AStarPlanner::getExpandedCount() const
+{
+    return this -> expanded;
+}
+
+void AStarPlanner::setHeuristic(const Heuristic & heuristicRef)
+{
+    this -> heuristic = & heuristicRef;
+}
+
+// returns the route length, or -1 if target cannot be reached
+
+int AStarPlanner::shortestPath(int source, int target, std::vector<int> & route)
+{
+    route.clear();
+    int rv = search(source, target, false, nullptr, nullptr);
+    if (rv >= 0)
+        for (int s = target; s >= 0; s = this -> parent[s])
+            route.push_back(s);
+    std::reverse(route.begin(), route.end());
+    return rv;
+}
+
+// shortest start -> any coffee station -> goal route, or -1 if there is none
+
+int AStarPlanner::coffeeRoute(int start, int goal, std::vector<int> & route)
+{
+    route.clear();
+    int vCount = this -> graph -> getVertexCount();
+    if (start < 0 || start >= vCount || goal < 0 || goal >= vCount)
+        return -1;
+    int source = start + (this -> graph -> getVertex(start).getC() ? vCount : 0);
+    int rv = search(source, goal + vCount, true, nullptr, nullptr);
+    if (rv >= 0)
+        for (int s = goal + vCount; s >= 0; s = this -> parent[s])
+            route.push_back(s % vCount);
+    std::reverse(route.begin(), route.end());
+    return rv;
+}
+
+// the same with the cells and passages closed in overlay avoided; the heuristic
+// stays admissible, closures only lengthen routes
+
+int AStarPlanner::coffeeRoute(int start, int goal, std::vector<int> & route, const QueryOverlay & overlay)
+{
+    route.clear();
+    int vCount = this -> graph -> getVertexCount();
+    if (start < 0 || start >= vCount || goal < 0 || goal >= vCount || overlay.isVertexBlocked(start))
+        return -1;
+    int source = start + (this -> graph -> getVertex(start).getC() ? vCount : 0);
+    int rv = search(source, goal + vCount, true, & overlay, nullptr);
+    if (rv >= 0)
+        for (int s = goal + vCount; s >= 0; s = this -> parent[s])
+            route.push_back(s % vCount);
+    std::reverse(route.begin(), route.end());
+    return rv;
+}
+
+// under a deadline or cancellation token; a search cut short returns no route
+
+SearchResult AStarPlanner::shortestPath(int source, int target, std::vector<int> & route, SearchLimit & limit)
+{
+    route.clear();
+    int rv = search(source, target, false, nullptr, & limit);
+    if (rv >= 0)
+        for (int s = target; s >= 0; s = this -> parent[s])
+            route.push_back(s);
+    std::reverse(route.begin(), route.end());
+    return limit.finish(rv);
+}
+
+SearchResult AStarPlanner::coffeeRoute(int start, int goal, std::vector<int> & route, SearchLimit & limit)
+{
+    route.clear();
+    int vCount = this -> graph -> getVertexCount();
+    if (start < 0 || start >= vCount || goal < 0 || goal >= vCount)
+        return limit.finish(-1);
+    int source = start + (this -> graph -> getVertex(start).getC() ? vCount : 0);
+    int rv = search(source, goal + vCount, true, nullptr, & limit);
+    if (rv >= 0)
+        for (int s = goal + vCount; s >= 0; s = this -> parent[s])
+            route.push_back(s % vCount);
+    std::reverse(route.begin(), route.end());
+    return limit.finish(rv);
+}
+
+int AStarPlanner::estimate(int state, int goal, bool coffeeMode) const
+{
+    int vCount = this -> graph -> getVertexCount();
+    if (!coffeeMode || state >= vCount)
+        return this -> heuristic -> bound(state % vCount, goal);
+    int best = Heuristic::UNREACHABLE;
+    for (size_t i = 0; i < this -> coffee.size(); i++)
+    {
+        int b = this -> heuristic -> bound(state, this -> coffee[i]);
+        if (b < Heuristic::UNREACHABLE)
+            b += this -> heuristic -> bound(this -> coffee[i], goal);
+        best = std::min(best, b);
+    }
+    return best;
+}
+
+// g, h and parent hold a state's values only when seen[state] is the current
+// generation; a stale state is reset when a search first reaches it, so starting
+// a search is one increment instead of clearing 2V entries of each array
+
+void AStarPlanner::touch(int state)
+{
+    if (this -> seen[state] != this -> generation)
+    {
+        this -> seen[state] = this -> generation;
+        this -> g[state] = -1;
+        this -> h[state] = -1;
+        this -> parent[state] = -1;
+    }
+}
+
+// the arrays are sized by the constructor; they are cleared once per 2^32
+// searches when the counter wraps
+
+int AStarPlanner::search(int source, int target, bool coffeeMode, const QueryOverlay * overlay, SearchLimit * limit)
+{
+    int vCount = this -> graph -> getVertexCount();
+    int states = coffeeMode ? 2 * vCount : vCount;
+    int goal = target % std::max(1, vCount);
+    this -> expanded = 0;
+    if (source < 0 || source >= states || target < 0 || target >= states)
+        return -1;
+    this -> generation++;
+    if (this -> generation == 0)
+    {
+        std::fill(this -> seen.begin(), this -> seen.end(), 0);
+        this -> generation = 1;
+    }
+    touch(source);
+
+    // f grows by at most w + (bound change <= w) per push
+
+    this -> queue.setMaxWeight(2 * this -> graph -> getMaxWeight());
+    this -> g[source] = 0;
+    this -> h[source] = estimate(source, goal, coffeeMode);
+    if (this -> h[source] >= Heuristic::UNREACHABLE)
+        return -1;
+    this -> queue.push(source, this -> h[source]);
+
+    int u;
+    int key;
+    while (this -> queue.pop(u, key))
+    {
+        if (key != this -> g[u] + this -> h[u])
+            continue;
+        if (limit != nullptr && limit -> shouldStop())
+            return -1;
+        this -> expanded++;
+        if (u == target)
+            return this -> g[u];
+
+        int layer = (u >= vCount) ? vCount : 0;
+        int pivot = u - layer;
+        for (int e = this -> graph -> getFirstEdge(pivot); e < this -> graph -> getLastEdge(pivot); e++)
+        {
+            int v = this -> graph -> getTarget(e);
+            if (overlay != nullptr && !overlay -> allows(e, v))
+                continue;
+            int next = v + layer;
+            if (coffeeMode && layer == 0 && this -> graph -> getVertex(v).getC())
+                next = v + vCount;
+            int ng = this -> g[u] + this -> graph -> getWeight(e);
+            touch(next);
+            if (this -> g[next] < 0 || ng < this -> g[next])
+            {
+                if (this -> h[next] < 0)
+                    this -> h[next] = estimate(next, goal, coffeeMode);
+                if (this -> h[next] >= Heuristic::UNREACHABLE)
+                    continue;
+                this -> g[next] = ng;
+                this -> parent[next] = u;
+                this -> queue.push(next, ng + this -> h[next]);
+            }
+        }
+    }
+    return -1;
+}
+
+#endif /* heuristicSearch_h */
@@ -0,0 +1,621 @@
+//  hierarchicalPlanner.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Hierarchical pathfinding (HPA*) over fixed-size floor clusters.
+
+#ifndef hierarchicalPlanner_h
+#define hierarchicalPlanner_h
+#include <chrono>
+#include <functional>
+#include <queue>
+#include <vector>
+#include "floorGraph.h"
+#include "floorMap.h"
+#include "searchLimit.h"
+#include "weightedSearch.h"
+
+// the floor is cut into clusterSize x clusterSize squares
+// every run of open cell pairs along a cluster border gets one entrance (its middle pair)
+// abstract nodes of a cluster are its entrance cells and its coffee stations,
+// joined by intra-cluster distances and by the one-step edges across borders
+// start and goal are inserted for the length of a query only
+// routes are near-optimal: crossings are restricted to the chosen entrances
+
+class ClusterHierarchy
+{
+    private: // data elements
+        const FloorGraph * graph;
+        int clusterSize;
+        int clustersX;
+        int clustersY;
+        std::vector<char> closed;
+        std::vector<int> clusterOf;
+        std::vector<int> localIndex;
+        std::vector<std::vector<int>> nodes;
+        std::vector<std::vector<std::vector<int>>> intra;
+        std::vector<std::vector<int>> rightLinks;
+        std::vector<std::vector<int>> downLinks;
+
+    private: // scratch
+        BucketQueue queue;
+        std::vector<int> localDist;
+        std::vector<int> localParent;
+        std::vector<int> stateDist;
+        std::vector<int> stateParent;
+        std::vector<int> stateStamp;
+        int stamp;
+
+    private: // statistics of the last query or update
+        int abstractExpanded;
+        int refinedClusters;
+        int updatedClusters;
+
+    public:
+        ClusterHierarchy(const FloorGraph &, int);
+
+    public: // accessors
+        int getClusterSize() const;
+        int getClusterCount() const;
+        int getClusterOf(int) const;
+        int getAbstractNodeCount() const;
+        int getAbstractExpanded() const;
+        int getRefinedClusters() const;
+        int getUpdatedClusters() const;
+
+    public: // local map changes
+        bool setCellOpen(int, int, bool);
+        void updateCluster(int);
+
+    public: // queries
+        int coffeeRoute(int, int, std::vector<int> &);
+        SearchResult coffeeRoute(int, int, std::vector<int> &, SearchLimit &);
+
+    private:
+        int search(int, int, std::vector<int> &, SearchLimit *);
+        int neighbourCluster(int, int, int) const;
+        int localCell(int) const;
+        int edgeWeight(int, int) const;
+        void clusterSearch(int);
+        void scanBorder(int, bool);
+        void collectNodes(int);
+        void computeIntra(int);
+        bool insertNode(int);
+        void removeNode(int);
+        template <typename Visit> void forEachAbstractNeighbour(int, Visit) const;
+};
+
+ClusterHierarchy::ClusterHierarchy(const FloorGraph & g, int size)
+{
+    this -> graph = & g;
+    this -> clusterSize = std::max(2, size);
+    this -> clustersX = (g.getWidth() + this -> clusterSize - 1) / this -> clusterSize;
+    this -> clustersY = (g.getHeight() + this -> clusterSize - 1) / this -> clusterSize;
+    this -> stamp = 0;
+    this -> abstractExpanded = 0;
+    this -> refinedClusters = 0;
+    this -> updatedClusters = 0;
+
+    int vCount = g.getVertexCount();
+    int cCount = this -> clustersX * this -> clustersY;
+    this -> closed.assign(vCount, 0);
+    this -> clusterOf.assign(vCount, 0);
+    this -> localIndex.assign(vCount, -1);
+    for (int v = 0; v < vCount; v++)
+    {
+        int cx = (g.getVertex(v).getX() - g.getMinX()) / this -> clusterSize;
+        int cy = (g.getVertex(v).getY() - g.getMinY()) / this -> clusterSize;
+        this -> clusterOf[v] = cy * this -> clustersX + cx;
+    }
+
+    this -> nodes.assign(cCount, std::vector<int>());
+    this -> intra.assign(cCount, std::vector<std::vector<int>>());
+    this -> rightLinks.assign(cCount, std::vector<int>());
+    this -> downLinks.assign(cCount, std::vector<int>());
+    this -> localDist.assign(this -> clusterSize * this -> clusterSize, -1);
+    this -> localParent.assign(this -> clusterSize * this -> clusterSize, -1);
+    this -> stateDist.assign(2 * vCount, -1);
+    this -> stateParent.assign(2 * vCount, -1);
+    this -> stateStamp.assign(2 * vCount, 0);
+    this -> queue.setMaxWeight(g.getMaxWeight());
+
+    for (int c = 0; c < cCount; c++)
+    {
+        scanBorder(c, true);
+        scanBorder(c, false);
+    }
+    for (int c = 0; c < cCount; c++)
+    {
+        collectNodes(c);
+        computeIntra(c);
+    }
+    this -> updatedClusters = cCount;
+}
+
+int ClusterHierarchy::getClusterSize() const
+{
+    return this -> clusterSize;
+}
+
+int ClusterHierarchy::getClusterCount() const
+{
+    return this -> clustersX * this -> clustersY;
+}
+
+int ClusterHierarchy::getClusterOf(int v) const
+{
+    return this -> clusterOf[v];
+}
+
+int ClusterHierarchy::getAbstractNodeCount() const
+{
+    int rv = 0;
+    for (size_t c = 0; c < this -> nodes.size(); c++)
+        rv += (int) this -> nodes[c].size();
+    return rv;
+}
+
+int ClusterHierarchy::getAbstractExpanded() const
+{
+    return this -> abstractExpanded;
+}
+
+int ClusterHierarchy::getRefinedClusters() const
+{
+    return this -> refinedClusters;
+}
+
+int ClusterHierarchy::getUpdatedClusters() const
+{
+    return this -> updatedClusters;
+}
+
+// close or reopen one cell and repair only the clusters that can see it
+// returns false if (x, y) is not a vertex of the graph
+
+bool ClusterHierarchy::setCellOpen(int x, int y, bool open)
+{
+    int v = this -> graph -> findId(x, y);
+    if (v < 0)
+        return false;
+    this -> closed[v] = open ? 0 : 1;
+    updateCluster(this -> clusterOf[v]);
+    return true;
+}
+
+// rescans the four borders of cluster c, then recomputes the abstract nodes and
+// intra distances of c and its four neighbours; the rest of the hierarchy is untouched
+
+void ClusterHierarchy::updateCluster(int c)
+{
+    int left = neighbourCluster(c, -1, 0);
+    int up = neighbourCluster(c, 0, -1);
+    scanBorder(c, true);
+    scanBorder(c, false);
+    if (left >= 0)
+        scanBorder(left, true);
+    if (up >= 0)
+        scanBorder(up, false);
+
+    int affected [5] = { c, left, up, neighbourCluster(c, 1, 0), neighbourCluster(c, 0, 1) };
+    this -> updatedClusters = 0;
+    for (int i = 0; i < 5; i++)
+        if (affected[i] >= 0)
+        {
+            collectNodes(affected[i]);
+            computeIntra(affected[i]);
+            this -> updatedClusters++;
+        }
+}
+
+int ClusterHierarchy::neighbourCluster(int c, int dx, int dy) const
+{
+    int cx = c % this -> clustersX + dx;
+    int cy = c / this -> clustersX + dy;
+    if (cx < 0 || cy < 0 || cx >= this -> clustersX || cy >= this -> clustersY)
+        return -1;
+    return cy * this -> clustersX + cx;
+}
+
+// position of vertex v inside its cluster square
+
+int ClusterHierarchy::localCell(int v) const
+{
+    int lx = (this -> graph -> getVertex(v).getX() - this -> graph -> getMinX()) % this -> clusterSize;
+    int ly = (this -> graph -> getVertex(v).getY() - this -> graph -> getMinY()) % this -> clusterSize;
+    return ly * this -> clusterSize + lx;
+}
+
+int ClusterHierarchy::edgeWeight(int u, int v) const
+{
+    for (int e = this -> graph -> getFirstEdge(u); e < this -> graph -> getLastEdge(u); e++)
+        if (this -> graph -> getTarget(e) == v)
+            return this -> graph -> getWeight(e);
+    return -1;
+}
+
+// Dijkstra from source that never leaves the cluster of source
+// results are in localDist / localParent, indexed by localCell
+
+void ClusterHierarchy::clusterSearch(int source)
+{
+    int c = this -> clusterOf[source];
+    std::fill(this -> localDist.begin(), this -> localDist.end(), -1);
+    std::fill(this -> localParent.begin(), this -> localParent.end(), -1);
+    this -> queue.clear();
+    this -> localDist[localCell(source)] = 0;
+    this -> queue.push(source, 0);
+
+    int u;
+    int key;
+    while (this -> queue.pop(u, key))
+    {
+        if (key != this -> localDist[localCell(u)])
+            continue;
+        for (int e = this -> graph -> getFirstEdge(u); e < this -> graph -> getLastEdge(u); e++)
+        {
+            int v = this -> graph -> getTarget(e);
+            if (this -> clusterOf[v] != c || this -> closed[v])
+                continue;
+            int nd = key + this -> graph -> getWeight(e);
+            int cell = localCell(v);
+            if (this -> localDist[cell] < 0 || nd < this -> localDist[cell])
+            {
+                this -> localDist[cell] = nd;
+                this -> localParent[cell] = u;
+                this -> queue.push(v, nd);
+            }
+        }
+    }
+}
+
+// entrances between cluster c and its right (or lower) neighbour, stored as (a, b, w) triples
+
+void ClusterHierarchy::scanBorder(int c, bool right)
+{
+    std::vector<int> & links = right ? this -> rightLinks[c] : this -> downLinks[c];
+    links.clear();
+    int other = right ? neighbourCluster(c, 1, 0) : neighbourCluster(c, 0, 1);
+    if (other < 0)
+        return;
+
+    int x0 = this -> graph -> getMinX() + (c % this -> clustersX) * this -> clusterSize;
+    int y0 = this -> graph -> getMinY() + (c / this -> clustersX) * this -> clusterSize;
+    std::vector<int> run;
+    for (int i = 0; i <= this -> clusterSize; i++)
+    {
+        int a = -1;
+        int b = -1;
+        if (i < this -> clusterSize)
+        {
+            int x = right ? x0 + this -> clusterSize - 1 : x0 + i;
+            int y = right ? y0 + i : y0 + this -> clusterSize - 1;
+            a = this -> graph -> findId(x, y);
+            b = right ? this -> graph -> findId(x + 1, y) : this -> graph -> findId(x, y + 1);
+        }
+        bool usable = a >= 0 && b >= 0 && !this -> closed[a] && !this -> closed[b] && edgeWeight(a, b) > 0;
+        if (usable)
+        {
+            run.push_back(a);
+            run.push_back(b);
+        }
+        else if (run.size() > 0)
+        {
+            size_t mid = (run.size() / 2) & ~((size_t) 1);
+            links.push_back(run[mid]);
+            links.push_back(run[mid + 1]);
+            links.push_back(edgeWeight(run[mid], run[mid + 1]));
+            run.clear();
+        }
+    }
+}
+
+void ClusterHierarchy::collectNodes(int c)
+{
+    std::vector<int> & list = this -> nodes[c];
+    for (size_t i = 0; i < list.size(); i++)
+        this -> localIndex[list[i]] = -1;
+    list.clear();
+
+    std::vector<int> candidates;
+    int left = neighbourCluster(c, -1, 0);
+    int up = neighbourCluster(c, 0, -1);
+    for (size_t i = 0; i < this -> rightLinks[c].size(); i += 3)
+        candidates.push_back(this -> rightLinks[c][i]);
+    for (size_t i = 0; i < this -> downLinks[c].size(); i += 3)
+        candidates.push_back(this -> downLinks[c][i]);
+    if (left >= 0)
+        for (size_t i = 0; i < this -> rightLinks[left].size(); i += 3)
+            candidates.push_back(this -> rightLinks[left][i + 1]);
+    if (up >= 0)
+        for (size_t i = 0; i < this -> downLinks[up].size(); i += 3)
+            candidates.push_back(this -> downLinks[up][i + 1]);
+
+    // coffee stations are permanent abstract nodes
+
+    int x0 = this -> graph -> getMinX() + (c % this -> clustersX) * this -> clusterSize;
+    int y0 = this -> graph -> getMinY() + (c / this -> clustersX) * this -> clusterSize;
+    for (int y = y0; y < y0 + this -> clusterSize; y++)
+        for (int x = x0; x < x0 + this -> clusterSize; x++)
+        {
+            int v = this -> graph -> findId(x, y);
+            if (v >= 0 && !this -> closed[v] && this -> graph -> getVertex(v).getC())
+                candidates.push_back(v);
+        }
+
+    for (size_t i = 0; i < candidates.size(); i++)
+        if (this -> localIndex[candidates[i]] < 0)
+        {
+            this -> localIndex[candidates[i]] = (int) list.size();
+            list.push_back(candidates[i]);
+        }
+}
+
+void ClusterHierarchy::computeIntra(int c)
+{
+    std::vector<int> & list = this -> nodes[c];
+    std::vector<std::vector<int>> & table = this -> intra[c];
+    table.assign(list.size(), std::vector<int>(list.size(), -1));
+    for (size_t i = 0; i < list.size(); i++)
+    {
+        clusterSearch(list[i]);
+        for (size_t j = 0; j < list.size(); j++)
+            table[i][j] = this -> localDist[localCell(list[j])];
+    }
+}
+
+// temporary abstract node for a query endpoint; returns false if v already is one
+
+bool ClusterHierarchy::insertNode(int v)
+{
+    if (this -> localIndex[v] >= 0)
+        return false;
+    int c = this -> clusterOf[v];
+    std::vector<int> & list = this -> nodes[c];
+    std::vector<std::vector<int>> & table = this -> intra[c];
+
+    clusterSearch(v);
+    std::vector<int> row;
+    for (size_t j = 0; j < list.size(); j++)
+    {
+        int d = this -> localDist[localCell(list[j])];
+        row.push_back(d);
+        table[j].push_back(d);
+    }
+    row.push_back(0);
+    table.push_back(row);
+    this -> localIndex[v] = (int) list.size();
+    list.push_back(v);
+    return true;
+}
+
+// undoes the most recent insertNode in the cluster of v
+
+void ClusterHierarchy::removeNode(int v)
+{
+    int c = this -> clusterOf[v];
+    std::vector<std::vector<int>> & table = this -> intra[c];
+    table.pop_back();
+    for (size_t j = 0; j < table.size(); j++)
+        table[j].pop_back();
+    this -> nodes[c].pop_back();
+    this -> localIndex[v] = -1;
+}
+
+template <typename Visit>
+void ClusterHierarchy::forEachAbstractNeighbour(int v, Visit visit) const
+{
+    int c = this -> clusterOf[v];
+    int i = this -> localIndex[v];
+    const std::vector<int> & list = this -> nodes[c];
+    for (size_t j = 0; j < list.size(); j++)
+        if ((int) j != i && this -> intra[c][i][j] > 0)
+            visit(list[j], this -> intra[c][i][j]);
+
+    const std::vector<int> * borders [4] = { & this -> rightLinks[c], & this -> downLinks[c], nullptr, nullptr };
+    int left = neighbourCluster(c, -1, 0);
+    int up = neighbourCluster(c, 0, -1);
+    if (left >= 0)
+        borders[2] = & this -> rightLinks[left];
+    if (up >= 0)
+        borders[3] = & this -> downLinks[up];
+    for (int k = 0; k < 4; k++)
+        if (borders[k] != nullptr)
+            for (size_t t = 0; t < borders[k] -> size(); t += 3)
+            {
+                if (k < 2 && (*borders[k])[t] == v)
+                    visit((*borders[k])[t + 1], (*borders[k])[t + 2]);
+                if (k >= 2 && (*borders[k])[t + 1] == v)
+                    visit((*borders[k])[t], (*borders[k])[t + 2]);
+            }
+}
+
+// start -> any coffee station -> goal, searched on the abstract graph and then
+// refined cluster by cluster; returns the route length, or -1 if there is none
+
+int ClusterHierarchy::coffeeRoute(int start, int goal, std::vector<int> & route)
+{
+    return search(start, goal, route, nullptr);
+}
+
+// under a deadline or cancellation token; a search cut short returns no route
+
+SearchResult ClusterHierarchy::coffeeRoute(int start, int goal, std::vector<int> & route, SearchLimit & limit)
+{
+    return limit.finish(search(start, goal, route, & limit));
+}
+
+// limit is nullptr for an unrestricted search; it is checked per abstract node
+// expanded and once per refined cluster, and start and goal are removed again
+// however the search ends
+
+int ClusterHierarchy::search(int start, int goal, std::vector<int> & route, SearchLimit * limit)
+{
+    route.clear();
+    this -> abstractExpanded = 0;
+    this -> refinedClusters = 0;
+    int vCount = this -> graph -> getVertexCount();
+    if (start < 0 || goal < 0 || start >= vCount || goal >= vCount || this -> closed[start] || this -> closed[goal])
+        return -1;
+
+    bool startInserted = insertNode(start);
+    bool goalInserted = insertNode(goal);
+
+    // Dijkstra over (abstract node, hasCoffee) states, arrays reset by stamp
+
+    this -> stamp++;
+    typedef std::pair<int, int> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    int source = start + (this -> graph -> getVertex(start).getC() ? vCount : 0);
+    int target = goal + vCount;
+    this -> stateStamp[source] = this -> stamp;
+    this -> stateDist[source] = 0;
+    this -> stateParent[source] = -1;
+    open.push(Entry(0, source));
+
+    int rv = -1;
+    while (!open.empty())
+    {
+        Entry top = open.top();
+        open.pop();
+        int u = top.second;
+        if (top.first != this -> stateDist[u])
+            continue;
+        if (limit != nullptr && limit -> shouldStop())
+            break;
+        this -> abstractExpanded++;
+        if (u == target)
+        {
+            rv = top.first;
+            break;
+        }
+        int layer = (u >= vCount) ? vCount : 0;
+        forEachAbstractNeighbour(u - layer, [&](int v, int w)
+        {
+            int next = v + layer;
+            if (layer == 0 && this -> graph -> getVertex(v).getC())
+                next = v + vCount;
+            int nd = top.first + w;
+            if (this -> stateStamp[next] != this -> stamp || nd < this -> stateDist[next])
+            {
+                this -> stateStamp[next] = this -> stamp;
+                this -> stateDist[next] = nd;
+                this -> stateParent[next] = u;
+                open.push(Entry(nd, next));
+            }
+        });
+    }
+
+    // refinement: inter-cluster steps are single edges, intra-cluster steps are searched in their cluster
+
+    if (rv >= 0)
+    {
+        std::vector<int> abstractPath;
+        for (int s = target; s >= 0; s = this -> stateParent[s])
+            abstractPath.push_back(s % vCount);
+        std::reverse(abstractPath.begin(), abstractPath.end());
+
+        route.push_back(abstractPath[0]);
+        for (size_t i = 1; i < abstractPath.size(); i++)
+        {
+            int a = abstractPath[i - 1];
+            int b = abstractPath[i];
+            if (this -> clusterOf[a] != this -> clusterOf[b])
+            {
+                route.push_back(b);
+                continue;
+            }
+            if (limit != nullptr && limit -> checkNow())
+            {
+                route.clear();
+                rv = -1;
+                break;
+            }
+            clusterSearch(a);
+            this -> refinedClusters++;
+            std::vector<int> leg;
+            for (int v = b; v != a; v = this -> localParent[localCell(v)])
+                leg.push_back(v);
+            route.insert(route.end(), leg.rbegin(), leg.rend());
+        }
+    }
+
+    if (goalInserted)
+        removeNode(goal);
+    if (startInserted)
+        removeNode(start);
+    return rv;
+}
+
+void runHierarchicalPlanner()
+{
+    std::cout << "Hierarchical planning will start.";
+
+    // demo floor: HPA* only crosses clusters at entrance midpoints, so its
+    // route is near-optimal rather than shortest; print the gap to the flat planner
+
+    std::vector<Vertex> U;
+    std::vector<Edge> edgeVector;
+    FloorMap::demoFloor().makeEdgesAndVertices(U, edgeVector);
+    FloorGraph graph(U, edgeVector);
+    ClusterHierarchy hierarchy(graph, 3);
+    DijkstraPlanner flat(graph);
+
+    std::vector<int> route;
+    int length = hierarchy.coffeeRoute(graph.findId(3, 2), graph.findId(3, 4), route);
+    std::cout << "\nHPA* coffee route of length " << length << ":";
+    graph.printRoute(route);
+    int flatShort = flat.coffeeRoute(graph.findId(3, 2), graph.findId(3, 4), route);
+    std::cout << "\nFlat Dijkstra length: " << flatShort << ", HPA* is " << length - flatShort << " longer.";
+
+    // building scale: 16 x 16 rooms of 15 x 15 cells, one door per wall
+
+    const int ROOM = 16;
+    const int ROOMS = 16;
+    FloorMap building(ROOM * ROOMS, ROOM * ROOMS);
+    for (int y = 0; y < building.getHeight(); y++)
+        for (int x = 0; x < building.getWidth(); x++)
+            if (x % ROOM == ROOM - 1 || y % ROOM == ROOM - 1)
+                building.setCell(x, y, '#');
+    for (int ry = 0; ry < ROOMS; ry++)
+        for (int rx = 0; rx < ROOMS; rx++)
+        {
+            building.setCell(rx * ROOM + ROOM - 1, ry * ROOM + (rx * 5 + ry * 3) % (ROOM - 1), '.');
+            building.setCell(rx * ROOM + (rx * 3 + ry * 7) % (ROOM - 1), ry * ROOM + ROOM - 1, '.');
+        }
+    building.setCell(ROOM * ROOMS / 2, 3, 'C');
+    building.setCell(5, ROOM * ROOMS - 6, 'C');
+
+    std::vector<Vertex> bigU;
+    std::vector<Edge> bigEdges;
+    building.makeEdgesAndVertices(bigU, bigEdges);
+    FloorGraph bigGraph(bigU, bigEdges);
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    ClusterHierarchy bigHierarchy(bigGraph, ROOM);
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    int start = bigGraph.findId(1, 1);
+    int goal = bigGraph.findId(ROOM * ROOMS - 3, ROOM * ROOMS - 3);
+    int hpaLength = bigHierarchy.coffeeRoute(start, goal, route);
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+    DijkstraPlanner bigFlat(bigGraph);
+    int flatLength = bigFlat.coffeeRoute(start, goal, route);
+    std::chrono::steady_clock::time_point t3 = std::chrono::steady_clock::now();
+
+    std::cout << "\n" << bigGraph.getVertexCount() << " vertices, " << bigHierarchy.getClusterCount() << " clusters, ";
+    std::cout << bigHierarchy.getAbstractNodeCount() << " abstract nodes.";
+    std::cout << "\nBuild: " << std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() << " us.";
+    std::cout << "\nHPA*: length " << hpaLength << ", " << bigHierarchy.getAbstractExpanded() << " abstract nodes expanded, ";
+    std::cout << bigHierarchy.getRefinedClusters() << " clusters refined, ";
+    std::cout << std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count() << " us.";
+    std::cout << "\nFlat: length " << flatLength << " (HPA* gap " << hpaLength - flatLength << "), ";
+    std::cout << bigFlat.getSettledCount() << " states settled, ";
+    std::cout << std::chrono::duration_cast<std::chrono::microseconds>(t3 - t2).count() << " us.";
+
+    // close a door and repair the hierarchy locally
+
+    bigHierarchy.setCellOpen(ROOM - 1, (0 * 5 + 0 * 3) % (ROOM - 1), false);
+    std::cout << "\nDoor closed, " << bigHierarchy.getUpdatedClusters() << " clusters updated.";
+    std::cout << "\nHPA* length after closure: " << bigHierarchy.coffeeRoute(start, goal, route) << ".";
+}
+
+#endif /* hierarchicalPlanner_h */
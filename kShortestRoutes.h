@@ -0,0 +1,512 @@
+//  kShortestRoutes.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Lazy k-shortest start -> coffee -> goal routes (Yen's algorithm).
+
+#ifndef kShortestRoutes_h
+#define kShortestRoutes_h
+#include <chrono>
+#include <functional>
+#include <queue>
+#include <set>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "floorGraph.h"
+#include "floorMap.h"
+#include "searchLimit.h"
+#include "weightedSearch.h"
+
+// routes are simple paths over the DijkstraPlanner states (v before the coffee,
+// v + V once it is carried), so a route may pass a cell once on the way to the
+// station and once more on the way back, but never loops within either leg
+// next() returns one route at a time; begin() computes exact distances to the goal
+// once, so a deviation at a spur is scored without searching by its best sidetrack,
+// w(spur, v) + toGoal[v] - toGoal[spur] over the first steps still allowed
+// only the best deviation per spur is kept, and only deviations that could beat
+// the cheapest known candidate are turned into routes: by following the exact
+// distances when that path avoids the blocked root, by an A* spur search otherwise
+
+class KShortestRoutes
+{
+    private: // data elements
+        const FloorGraph * graph;
+        BucketQueue queue;
+        std::vector<int> dist;
+        std::vector<int> parent;
+        std::vector<int> toGoal;
+        std::vector<int> seenStamp;
+        std::vector<int> blockedStamp;
+        std::vector<int> blockedNext;
+        int stamp;
+        int source;
+        int target;
+        std::vector<std::vector<int>> accepted;
+        std::set<std::pair<int, std::vector<int>>> candidates;
+        std::set<std::tuple<int, int, int>> deviations;
+        int scored;
+        int searches;
+
+    public:
+        KShortestRoutes(const FloorGraph &);
+
+    public: // accessors
+        int getRouteCount() const;
+        int getSearchCount() const;
+
+    public: // queries
+        bool begin(int, int);
+        int next(std::vector<int> &);
+        SearchResult next(std::vector<int> &, SearchLimit &);
+
+    private:
+        int nextRoute(std::vector<int> &, SearchLimit *);
+        void fillEstimates(int);
+        int stepCost(int, int) const;
+        int stepTo(int, int) const;
+        void blockRoot(int, int);
+        int bestFirstStep(int, int &) const;
+        bool followTree(int, int, std::vector<int> &) const;
+        int spurSearch(int, int, SearchLimit *);
+};
+
+KShortestRoutes::KShortestRoutes(const FloorGraph & g)
+{
+    this -> graph = & g;
+    this -> stamp = 0;
+    this -> source = -1;
+    this -> target = -1;
+    this -> scored = 0;
+    this -> searches = 0;
+}
+
+int KShortestRoutes::getRouteCount() const
+{
+    return (int) this -> accepted.size();
+}
+
+int KShortestRoutes::getSearchCount() const
+{
+    return this -> searches;
+}
+
+// forget earlier routes and set up a new query; returns false for bad ids
+
+bool KShortestRoutes::begin(int start, int goal)
+{
+    int vCount = this -> graph -> getVertexCount();
+    this -> accepted.clear();
+    this -> candidates.clear();
+    this -> deviations.clear();
+    this -> scored = 0;
+    this -> searches = 0;
+    this -> source = -1;
+    this -> target = -1;
+    if (start < 0 || start >= vCount || goal < 0 || goal >= vCount)
+        return false;
+    this -> source = start + (this -> graph -> getVertex(start).getC() ? vCount : 0);
+    this -> target = goal + vCount;
+    this -> dist.assign(2 * vCount, -1);
+    this -> parent.assign(2 * vCount, -1);
+    this -> seenStamp.assign(2 * vCount, 0);
+    this -> blockedStamp.assign(2 * vCount, 0);
+    this -> stamp = 0;
+    fillEstimates(goal);
+    return true;
+}
+
+// toGoal[s] is the exact cost from state s to the goal state, -1 if there is none
+// (edges are symmetric, so distances from the goal are distances to it)
+// after the coffee: d(v, goal); before it: min over stations c of d(v, c) + d(c, goal)
+
+void KShortestRoutes::fillEstimates(int goal)
+{
+    int vCount = this -> graph -> getVertexCount();
+    std::vector<int> plain;
+    std::vector<int> unused;
+    DijkstraPlanner dijkstra(*(this -> graph));
+    dijkstra.distances(goal, plain, unused);
+    this -> toGoal.assign(2 * vCount, -1);
+    for (int v = 0; v < vCount; v++)
+        this -> toGoal[v + vCount] = plain[v];
+
+    typedef std::pair<int, int> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    for (int v = 0; v < vCount; v++)
+        if (this -> graph -> getVertex(v).getC() && plain[v] >= 0)
+        {
+            this -> toGoal[v] = plain[v];
+            open.push(Entry(plain[v], v));
+        }
+    while (!open.empty())
+    {
+        Entry top = open.top();
+        open.pop();
+        if (top.first != this -> toGoal[top.second])
+            continue;
+        for (int e = this -> graph -> getFirstEdge(top.second); e < this -> graph -> getLastEdge(top.second); e++)
+        {
+            int v = this -> graph -> getTarget(e);
+            int nd = top.first + this -> graph -> getWeight(e);
+            if (this -> toGoal[v] < 0 || nd < this -> toGoal[v])
+            {
+                this -> toGoal[v] = nd;
+                open.push(Entry(nd, v));
+            }
+        }
+    }
+}
+
+// the next cheapest route as vertex ids; returns its cost, or -1 when there are no more
+
+int KShortestRoutes::next(std::vector<int> & route)
+{
+    return nextRoute(route, nullptr);
+}
+
+// under a deadline or cancellation token; a call cut short accepts no route and
+// keeps the routes accepted and the deviations scored so far, so a later next()
+// resumes where it stopped
+
+SearchResult KShortestRoutes::next(std::vector<int> & route, SearchLimit & limit)
+{
+    return limit.finish(nextRoute(route, & limit));
+}
+
+// limit is nullptr for an unrestricted call; it is checked per state expanded
+// and once per deviation turned into a route
+
+int KShortestRoutes::nextRoute(std::vector<int> & route, SearchLimit * limit)
+{
+    route.clear();
+    if (this -> source < 0)
+        return -1;
+    int vCount = this -> graph -> getVertexCount();
+
+    if (this -> accepted.empty())
+    {
+        this -> stamp++;
+        this -> blockedNext.clear();
+        int cost = spurSearch(this -> source, this -> target, limit);
+        if (limit != nullptr && limit -> isStopped())
+            return -1;
+        if (cost < 0)
+        {
+            this -> source = -1;
+            return -1;
+        }
+        std::vector<int> states;
+        for (int s = this -> target; s >= 0; s = this -> parent[s])
+            states.push_back(s);
+        std::reverse(states.begin(), states.end());
+        this -> candidates.insert(std::make_pair(cost, states));
+    }
+    else if (this -> scored < (int) this -> accepted.size())
+    {
+        // score a deviation from the last accepted route at every vertex but the
+        // target: (lower bound on its cost, route index, spur position)
+
+        // the root grows by one state per spur, so it is blocked incrementally and
+        // an earlier route shares the first i + 1 states while its common prefix lasts
+
+        int r = (int) this -> accepted.size() - 1;
+        const std::vector<int> & last = this -> accepted[r];
+        std::vector<size_t> common(r);
+        for (int a = 0; a < r; a++)
+        {
+            const std::vector<int> & p = this -> accepted[a];
+            size_t n = std::min(p.size(), last.size());
+            while (common[a] < n && p[common[a]] == last[common[a]])
+                common[a]++;
+        }
+        this -> stamp++;
+        int rootCost = 0;
+        for (size_t i = 0; i + 1 < last.size(); i++)
+        {
+            if (i > 0)
+            {
+                rootCost += stepCost(last[i - 1], last[i]);
+                this -> blockedStamp[last[i - 1]] = this -> stamp;
+            }
+            this -> blockedNext.clear();
+            this -> blockedNext.push_back(last[i + 1]);
+            for (int a = 0; a < r; a++)
+                if (common[a] > i && this -> accepted[a].size() > i + 1)
+                    this -> blockedNext.push_back(this -> accepted[a][i + 1]);
+            int first;
+            int bound = bestFirstStep(last[i], first);
+            if (bound >= 0)
+                this -> deviations.insert(std::make_tuple(rootCost + bound, r, (int) i));
+        }
+        this -> scored = r + 1;
+    }
+
+    // a deviation whose bound is not below the cheapest candidate cannot beat it
+
+    while (!this -> deviations.empty() && (this -> candidates.empty()
+        || std::get<0>(*(this -> deviations.begin())) < this -> candidates.begin() -> first))
+    {
+        if (limit != nullptr && limit -> checkNow())
+            return -1;
+        std::tuple<int, int, int> top = *(this -> deviations.begin());
+        int r = std::get<1>(top);
+        int i = std::get<2>(top);
+        const std::vector<int> & root = this -> accepted[r];
+        int spur = root[i];
+        blockRoot(r, i);
+        this -> deviations.erase(this -> deviations.begin());
+
+        // routes accepted since scoring may block the best first step; rescore then
+
+        int rootCost = 0;
+        for (int k = 1; k <= i; k++)
+            rootCost += stepCost(root[k - 1], root[k]);
+        int first;
+        int bound = bestFirstStep(spur, first);
+        if (bound < 0)
+            continue;
+        int cost = rootCost + bound;
+        if (cost > std::get<0>(top))
+        {
+            this -> deviations.insert(std::make_tuple(cost, r, i));
+            continue;
+        }
+
+        std::vector<int> states(root.begin(), root.begin() + i + 1);
+        if (!followTree(spur, first, states))
+        {
+            int spurCost = spurSearch(spur, this -> target, limit);
+            if (limit != nullptr && limit -> isStopped())
+            {
+                this -> deviations.insert(top);
+                return -1;
+            }
+            states.resize(i);
+            cost = -1;
+            if (spurCost >= 0)
+            {
+                cost = rootCost + spurCost;
+                for (int s = this -> target; s >= 0 && s != spur; s = this -> parent[s])
+                    states.push_back(s);
+                states.push_back(spur);
+                std::reverse(states.begin() + i, states.end());
+            }
+        }
+        if (cost >= 0)
+            this -> candidates.insert(std::make_pair(cost, states));
+    }
+
+    if (this -> candidates.empty())
+        return -1;
+    std::pair<int, std::vector<int>> best = *(this -> candidates.begin());
+    this -> candidates.erase(this -> candidates.begin());
+    this -> accepted.push_back(best.second);
+    for (size_t i = 0; i < best.second.size(); i++)
+        route.push_back(best.second[i] % vCount);
+    return best.first;
+}
+
+int KShortestRoutes::stepCost(int u, int v) const
+{
+    int vCount = this -> graph -> getVertexCount();
+    int a = u % vCount;
+    int b = v % vCount;
+    for (int e = this -> graph -> getFirstEdge(a); e < this -> graph -> getLastEdge(a); e++)
+        if (this -> graph -> getTarget(e) == b)
+            return this -> graph -> getWeight(e);
+    return 0;
+}
+
+// the state reached from state u over edge e (a coffee cell picks the coffee up)
+
+int KShortestRoutes::stepTo(int u, int e) const
+{
+    int vCount = this -> graph -> getVertexCount();
+    int v = this -> graph -> getTarget(e);
+    if (u >= vCount || this -> graph -> getVertex(v).getC())
+        return v + vCount;
+    return v;
+}
+
+// block the first i states of accepted route r, and the states that accepted
+// routes sharing its first i + 1 states take next, as Yen does for a spur at i;
+// routes accepted since r was are blocked too, so a deviation turned into a
+// route late cannot return one of them again
+
+void KShortestRoutes::blockRoot(int r, int i)
+{
+    const std::vector<int> & root = this -> accepted[r];
+    this -> stamp++;
+    for (int k = 0; k < i; k++)
+        this -> blockedStamp[root[k]] = this -> stamp;
+    this -> blockedNext.clear();
+    for (size_t a = 0; a < this -> accepted.size(); a++)
+    {
+        const std::vector<int> & p = this -> accepted[a];
+        if ((int) p.size() > i + 1 && std::equal(p.begin(), p.begin() + i + 1, root.begin()))
+            this -> blockedNext.push_back(p[i + 1]);
+    }
+}
+
+// min over the first steps still allowed from spur of w(spur, v) + toGoal[v],
+// a lower bound on any deviation there since blocking only lengthens routes;
+// first is the state it steps to; returns -1 if every step is blocked
+
+int KShortestRoutes::bestFirstStep(int spur, int & first) const
+{
+    int vCount = this -> graph -> getVertexCount();
+    int pivot = spur % vCount;
+    int best = -1;
+    first = -1;
+    for (int e = this -> graph -> getFirstEdge(pivot); e < this -> graph -> getLastEdge(pivot); e++)
+    {
+        int next = stepTo(spur, e);
+        if (this -> blockedStamp[next] == this -> stamp || this -> toGoal[next] < 0)
+            continue;
+        if (std::find(this -> blockedNext.begin(), this -> blockedNext.end(), next) != this -> blockedNext.end())
+            continue;
+        int score = this -> graph -> getWeight(e) + this -> toGoal[next];
+        if (best < 0 || score < best)
+        {
+            best = score;
+            first = next;
+        }
+    }
+    return best;
+}
+
+// append first and then exact shortest steps to the target; false if that
+// path meets the blocked root or the spur, when a spur search has to decide
+// (toGoal falls by at least 1 per step, so the walk ends)
+
+bool KShortestRoutes::followTree(int spur, int first, std::vector<int> & states) const
+{
+    int vCount = this -> graph -> getVertexCount();
+    int s = first;
+    while (s >= 0)
+    {
+        if (this -> blockedStamp[s] == this -> stamp || s == spur)
+            return false;
+        states.push_back(s);
+        if (s == this -> target)
+            return true;
+        int pivot = s % vCount;
+        int step = -1;
+        for (int e = this -> graph -> getFirstEdge(pivot); e < this -> graph -> getLastEdge(pivot) && step < 0; e++)
+        {
+            int next = stepTo(s, e);
+            if (this -> toGoal[next] >= 0 && this -> graph -> getWeight(e) + this -> toGoal[next] == this -> toGoal[s])
+                step = next;
+        }
+        s = step;
+    }
+    return false;
+}
+
+// A* over coffee states from spur, avoiding states stamped in blockedStamp
+// and, on the first step only, the states listed in blockedNext
+// blocking only lengthens routes, so toGoal stays a consistent lower bound
+// dist and parent are only valid where seenStamp matches, so no search clears them
+
+int KShortestRoutes::spurSearch(int spur, int goalState, SearchLimit * limit)
+{
+    this -> searches++;
+    int vCount = this -> graph -> getVertexCount();
+    if (this -> toGoal[spur] < 0)
+        return -1;
+    this -> queue.setMaxWeight(2 * this -> graph -> getMaxWeight());
+    this -> seenStamp[spur] = this -> stamp;
+    this -> dist[spur] = 0;
+    this -> parent[spur] = -1;
+    this -> queue.push(spur, this -> toGoal[spur]);
+
+    int u;
+    int key;
+    while (this -> queue.pop(u, key))
+    {
+        if (key != this -> dist[u] + this -> toGoal[u])
+            continue;
+        if (limit != nullptr && limit -> shouldStop())
+            break;
+        if (u == goalState)
+            return this -> dist[u];
+
+        int layer = (u >= vCount) ? vCount : 0;
+        int pivot = u - layer;
+        for (int e = this -> graph -> getFirstEdge(pivot); e < this -> graph -> getLastEdge(pivot); e++)
+        {
+            int v = this -> graph -> getTarget(e);
+            int next = v + layer;
+            if (layer == 0 && this -> graph -> getVertex(v).getC())
+                next = v + vCount;
+            if (this -> blockedStamp[next] == this -> stamp || next == spur || this -> toGoal[next] < 0)
+                continue;
+            if (u == spur && std::find(this -> blockedNext.begin(), this -> blockedNext.end(), next) != this -> blockedNext.end())
+                continue;
+            int nd = this -> dist[u] + this -> graph -> getWeight(e);
+            if (this -> seenStamp[next] != this -> stamp || nd < this -> dist[next])
+            {
+                this -> seenStamp[next] = this -> stamp;
+                this -> dist[next] = nd;
+                this -> parent[next] = u;
+                this -> queue.push(next, nd + this -> toGoal[next]);
+            }
+        }
+    }
+    return -1;
+}
+
+void runKShortestRoutes()
+{
+    std::cout << "K-shortest coffee routes will start.";
+
+    FloorMap floor = FloorMap::demoFloor();
+    std::vector<Vertex> U;
+    std::vector<Edge> edgeVector;
+    floor.makeEdgesAndVertices(U, edgeVector);
+    FloorGraph graph(U, edgeVector);
+
+    KShortestRoutes routes(graph);
+    std::vector<int> route;
+    routes.begin(graph.findId(3, 2), graph.findId(3, 4));
+    for (int k = 1; k <= 3; k++)
+    {
+        int cost = routes.next(route);
+        if (cost < 0)
+            break;
+        std::cout << "\nRoute " << k << " of cost " << cost << ":";
+        graph.printRoute(route);
+    }
+
+    // the first route against the first three on a larger floor
+
+    const int SIDE = 256;
+    FloorMap big(SIDE, SIDE);
+    for (int y = 0; y < SIDE; y++)
+        for (int x = 0; x < SIDE; x++)
+            if ((x * 7 + y * 13) % 11 == 0)
+                big.setCell(x, y, '#');
+    big.setCell(SIDE / 2, SIDE / 2, 'C');
+    std::vector<Vertex> bigU;
+    std::vector<Edge> bigEdges;
+    big.makeEdgesAndVertices(bigU, bigEdges);
+    FloorGraph bigGraph(bigU, bigEdges);
+    KShortestRoutes bigRoutes(bigGraph);
+    int start = bigGraph.findId(1, 1);
+    int goal = bigGraph.findId(SIDE - 2, 1);
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    bigRoutes.begin(start, goal);
+    bigRoutes.next(route);
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    bigRoutes.next(route);
+    bigRoutes.next(route);
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+    std::cout << "\n" << bigGraph.getVertexCount() << " vertices, route of " << route.size() << " vertices.";
+    std::cout << "\nk = 1: " << std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() << " us.";
+    std::cout << "\nk = 3: " << std::chrono::duration_cast<std::chrono::microseconds>(t2 - t0).count() << " us, ";
+    std::cout << bigRoutes.getSearchCount() << " searches.";
+}
+
+#endif /* kShortestRoutes_h */
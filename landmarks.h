@@ -0,0 +1,372 @@
+//  landmarks.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  ALT preprocessing: landmark distance tables and the triangle-inequality bound.
+
+#ifndef landmarks_h
+#define landmarks_h
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "floorGraph.h"
+#include "floorMap.h"
+#include "heuristicSearch.h"
+#include "weightedSearch.h"
+
+// landmark file, stored next to the map as <map file>.alt
+//   char[4]   "ALT2"
+//   uint64    FloorGraph::fingerprint of the map
+//   uint32    vertex count V
+//   uint32    landmark count k (at most MAX_LANDMARKS)
+//   int32[k]  landmark vertex ids
+//   uint16[V * k] distances, vertex-major (all landmarks of a vertex are adjacent)
+//   uint64    checksum of the ids and distances
+// load() checks k against the file size before allocating anything
+// distances above SATURATED are stored as SATURATED; clamping keeps |d(l, t) - d(l, u)|
+// a valid lower bound
+
+class LandmarkTable
+{
+    private: // data elements
+        const FloorGraph * graph;
+        std::vector<int> landmarks;
+        std::vector<uint16_t> table;
+
+    public:
+        static constexpr uint16_t UNREACHED = 0xffff;
+        static constexpr uint16_t SATURATED = 0xfffe;
+        static constexpr uint32_t MAX_LANDMARKS = 64;
+
+    public:
+        LandmarkTable(const FloorGraph &);
+
+    public: // accessors
+        int getLandmarkCount() const;
+        int getLandmark(int) const;
+        uint16_t getDistance(int, int) const;
+        size_t getTableBytes() const;
+
+    public: // preprocessing
+        void select(int);
+
+    public: // files
+        bool save(const std::string &) const;
+        bool load(const std::string &);
+        static std::string tableFileName(const std::string &);
+
+    private:
+        static uint64_t checksum(const std::vector<int> &, const std::vector<uint16_t> &);
+};
+
+LandmarkTable::LandmarkTable(const FloorGraph & g)
+{
+    this -> graph = & g;
+}
+
+int LandmarkTable::getLandmarkCount() const
+{
+    return (int) this -> landmarks.size();
+}
+
+int LandmarkTable::getLandmark(int i) const
+{
+    return this -> landmarks[i];
+}
+
+uint16_t LandmarkTable::getDistance(int i, int v) const
+{
+    return this -> table[(size_t) v * this -> landmarks.size() + i];
+}
+
+size_t LandmarkTable::getTableBytes() const
+{
+    return this -> table.size() * sizeof(uint16_t);
+}
+
+// farthest-point selection: every new landmark is the vertex farthest from all
+// landmarks chosen so far (unreached vertices count as farthest, so every component gets one)
+
+void LandmarkTable::select(int k)
+{
+    int vCount = this -> graph -> getVertexCount();
+    k = std::max(0, std::min(std::min(k, vCount), (int) MAX_LANDMARKS));
+    this -> landmarks.clear();
+    this -> table.assign((size_t) vCount * k, UNREACHED);
+
+    std::vector<int> dist;
+    std::vector<int> parent;
+    std::vector<long long> nearest(vCount, -1);
+    DijkstraPlanner dijkstra(*(this -> graph));
+
+    // seed: farthest vertex from vertex 0
+
+    int next = 0;
+    if (vCount > 0)
+    {
+        this -> graph -> bfs(0, dist, parent);
+        for (int v = 0; v < vCount; v++)
+            if (dist[v] > dist[next])
+                next = v;
+    }
+
+    for (int i = 0; i < k; i++)
+    {
+        this -> landmarks.push_back(next);
+        if (this -> graph -> isWeighted())
+            dijkstra.distances(next, dist, parent);
+        else
+            this -> graph -> bfs(next, dist, parent);
+
+        for (int v = 0; v < vCount; v++)
+        {
+            if (dist[v] >= 0)
+                this -> table[(size_t) v * k + i] = (uint16_t) std::min(dist[v], (int) SATURATED);
+            if (dist[v] >= 0 && (nearest[v] < 0 || dist[v] < nearest[v]))
+                nearest[v] = dist[v];
+        }
+
+        long long farthest = -1;
+        for (int v = 0; v < vCount; v++)
+        {
+            long long d = (nearest[v] < 0) ? (1LL << 40) : nearest[v];
+            if (d > farthest)
+            {
+                farthest = d;
+                next = v;
+            }
+        }
+    }
+}
+
+// FNV-1a over the ids, then the distances 8 bytes at a time
+
+uint64_t LandmarkTable::checksum(const std::vector<int> & ids, const std::vector<uint16_t> & values)
+{
+    uint64_t rv = 1469598103934665603ULL;
+    for (size_t i = 0; i < ids.size(); i++)
+        rv = (rv ^ (uint32_t) ids[i]) * 1099511628211ULL;
+    const char * bytes = (const char *) values.data();
+    size_t count = values.size() * sizeof(uint16_t);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        uint64_t word;
+        std::memcpy(& word, bytes + i, 8);
+        rv = (rv ^ word) * 1099511628211ULL;
+    }
+    for (; i < count; i++)
+        rv = (rv ^ (unsigned char) bytes[i]) * 1099511628211ULL;
+    return rv;
+}
+
+bool LandmarkTable::save(const std::string & fileName) const
+{
+    std::ofstream out(fileName.c_str(), std::ios::binary);
+    if (!out)
+        return false;
+    uint64_t print = this -> graph -> fingerprint();
+    uint32_t vCount = (uint32_t) this -> graph -> getVertexCount();
+    uint32_t k = (uint32_t) this -> landmarks.size();
+    out.write("ALT2", 4);
+    out.write((const char *) & print, sizeof(print));
+    out.write((const char *) & vCount, sizeof(vCount));
+    out.write((const char *) & k, sizeof(k));
+    for (uint32_t i = 0; i < k; i++)
+    {
+        int32_t id = this -> landmarks[i];
+        out.write((const char *) & id, sizeof(id));
+    }
+    out.write((const char *) this -> table.data(), (std::streamsize) (this -> table.size() * sizeof(uint16_t)));
+    uint64_t sum = checksum(this -> landmarks, this -> table);
+    out.write((const char *) & sum, sizeof(sum));
+    return (bool) out;
+}
+
+// returns false (and leaves the table empty) if the file was made for another map
+// or is damaged: a landmark count that does not match the file size, an id
+// outside the graph or a checksum mismatch
+
+bool LandmarkTable::load(const std::string & fileName)
+{
+    this -> landmarks.clear();
+    this -> table.clear();
+    std::ifstream in(fileName.c_str(), std::ios::binary);
+    if (!in)
+        return false;
+
+    char magic [4];
+    uint64_t print = 0;
+    uint32_t vCount = 0;
+    uint32_t k = 0;
+    in.read(magic, 4);
+    in.read((char *) & print, sizeof(print));
+    in.read((char *) & vCount, sizeof(vCount));
+    in.read((char *) & k, sizeof(k));
+    if (!in || std::memcmp(magic, "ALT2", 4) != 0 ||
+        print != this -> graph -> fingerprint() ||
+        vCount != (uint32_t) this -> graph -> getVertexCount() || k > MAX_LANDMARKS)
+        return false;
+    std::error_code error;
+    uintmax_t fileBytes = std::filesystem::file_size(fileName, error);
+    uintmax_t expected = 20 + 4 * (uintmax_t) k + 2 * (uintmax_t) vCount * k + 8;
+    if (error || fileBytes != expected)
+        return false;
+
+    std::vector<int> ids(k);
+    for (uint32_t i = 0; i < k; i++)
+    {
+        int32_t id = 0;
+        in.read((char *) & id, sizeof(id));
+        if (id < 0 || (uint32_t) id >= vCount)
+            return false;
+        ids[i] = id;
+    }
+    std::vector<uint16_t> values((size_t) vCount * k);
+    in.read((char *) values.data(), (std::streamsize) (values.size() * sizeof(uint16_t)));
+    uint64_t sum = 0;
+    in.read((char *) & sum, sizeof(sum));
+    if (!in || sum != checksum(ids, values))
+        return false;
+
+    this -> landmarks.swap(ids);
+    this -> table.swap(values);
+    return true;
+}
+
+std::string LandmarkTable::tableFileName(const std::string & mapFileName)
+{
+    return mapFileName + ".alt";
+}
+
+// max over landmarks l of |d(l, t) - d(l, u)|
+// a landmark that reaches exactly one of u and t proves they are in different components
+
+class LandmarkHeuristic : public Heuristic
+{
+    private: // data elements
+        const LandmarkTable * table;
+
+    public:
+        LandmarkHeuristic(const LandmarkTable &);
+
+    public:
+        int bound(int, int) const;
+};
+
+LandmarkHeuristic::LandmarkHeuristic(const LandmarkTable & t)
+{
+    this -> table = & t;
+}
+
+int LandmarkHeuristic::bound(int u, int t) const
+{
+    int rv = 0;
+    int k = this -> table -> getLandmarkCount();
+    for (int i = 0; i < k; i++)
+    {
+        int du = this -> table -> getDistance(i, u);
+        int dt = this -> table -> getDistance(i, t);
+        if (du == LandmarkTable::UNREACHED || dt == LandmarkTable::UNREACHED)
+        {
+            if (du != dt)
+                return Heuristic::UNREACHABLE;
+            continue;
+        }
+        rv = std::max(rv, (du > dt) ? du - dt : dt - du);
+    }
+    return rv;
+}
+
+void runLandmarks()
+{
+    std::cout << "Landmark preprocessing will start.";
+
+    // demo floor, written to disk with its landmark table
+
+    FloorMap floor = FloorMap::demoFloor();
+    std::vector<Vertex> U;
+    std::vector<Edge> edgeVector;
+    floor.makeEdgesAndVertices(U, edgeVector);
+    FloorGraph graph(U, edgeVector);
+
+    std::string mapFile = (std::filesystem::temp_directory_path() / "demoFloor.map").string();
+    floor.save(mapFile);
+    LandmarkTable built(graph);
+    built.select(4);
+    built.save(LandmarkTable::tableFileName(mapFile));
+
+    LandmarkTable table(graph);
+    if (!table.load(LandmarkTable::tableFileName(mapFile)))
+        std::cout << "\nLandmark table could not be loaded.";
+    std::cout << "\nLandmarks:";
+    for (int i = 0; i < table.getLandmarkCount(); i++)
+    {
+        Vertex v = graph.getVertex(table.getLandmark(i));
+        std::cout << "\n  " << i + 1 << ".\t";
+        v.printVertex();
+    }
+
+    ManhattanHeuristic manhattan(graph);
+    LandmarkHeuristic alt(table);
+    AStarPlanner planner(graph, manhattan);
+    std::vector<int> route;
+    int length = planner.coffeeRoute(graph.findId(3, 2), graph.findId(3, 4), route);
+    int plain = planner.getExpandedCount();
+    planner.setHeuristic(alt);
+    planner.coffeeRoute(graph.findId(3, 2), graph.findId(3, 4), route);
+    std::cout << "\nCoffee route of length " << length << ":";
+    graph.printRoute(route);
+    std::cout << "\nExpanded with Manhattan: " << plain << ", with landmarks: " << planner.getExpandedCount() << ".";
+
+    // rooms joined by single doors, where walls force detours
+
+    const int ROOM = 12;
+    const int ROOMS = 12;
+    FloorMap building(ROOM * ROOMS, ROOM * ROOMS);
+    for (int y = 0; y < building.getHeight(); y++)
+        for (int x = 0; x < building.getWidth(); x++)
+            if (x % ROOM == ROOM - 1 || y % ROOM == ROOM - 1)
+                building.setCell(x, y, '#');
+    for (int ry = 0; ry < ROOMS; ry++)
+        for (int rx = 0; rx < ROOMS; rx++)
+        {
+            building.setCell(rx * ROOM + ROOM - 1, ry * ROOM + (rx * 5 + ry * 3) % (ROOM - 1), '.');
+            building.setCell(rx * ROOM + (rx * 3 + ry * 7) % (ROOM - 1), ry * ROOM + ROOM - 1, '.');
+        }
+    building.setCell(ROOM * ROOMS / 2, 2, 'C');
+    building.setCell(3, ROOM * ROOMS / 2, 'C');
+
+    std::vector<Vertex> bigU;
+    std::vector<Edge> bigEdges;
+    building.makeEdgesAndVertices(bigU, bigEdges);
+    FloorGraph bigGraph(bigU, bigEdges);
+    LandmarkTable bigTable(bigGraph);
+    bigTable.select(8);
+    ManhattanHeuristic bigManhattan(bigGraph);
+    LandmarkHeuristic bigAlt(bigTable);
+    AStarPlanner bigPlanner(bigGraph, bigManhattan);
+
+    long long plainTotal = 0;
+    long long altTotal = 0;
+    const int QUERIES = 20;
+    for (int q = 0; q < QUERIES; q++)
+    {
+        int start = (q * 7919) % bigGraph.getVertexCount();
+        int goal = (q * 104729 + 17) % bigGraph.getVertexCount();
+        bigPlanner.setHeuristic(bigManhattan);
+        bigPlanner.coffeeRoute(start, goal, route);
+        plainTotal += bigPlanner.getExpandedCount();
+        bigPlanner.setHeuristic(bigAlt);
+        bigPlanner.coffeeRoute(start, goal, route);
+        altTotal += bigPlanner.getExpandedCount();
+    }
+    std::cout << "\n" << bigGraph.getVertexCount() << " vertices, " << bigTable.getLandmarkCount() << " landmarks, ";
+    std::cout << bigTable.getTableBytes() << " table bytes.";
+    std::cout << "\nExpanded over " << QUERIES << " coffee queries with Manhattan: " << plainTotal;
+    std::cout << ", with landmarks: " << altTotal << ".";
+}
+
+#endif /* landmarks_h */
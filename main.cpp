@@ -4,11 +4,106 @@
 //  Created by Kenn Lui on 2021-11-21.
 //  kenn_lui@sfu.ca
 
+#include <climits>
+#include <cstdlib>
 #include <iostream>
+#include <string>
+#include "anytimePlanner.h"
+#include "batteryPlanner.h"
+#include "beamSearch.h"
+#include "corridorGraph.h"
+#include "distanceStore.h"
+#include "floorGenerator.h"
 #include "graphSolution.h"
+#include "hierarchicalPlanner.h"
+#include "kShortestRoutes.h"
+#include "landmarks.h"
+#include "moveString.h"
+#include "oneToMany.h"
+#include "parallelBuild.h"
+#include "pathGenerator.h"
+#include "plannerDaemon.h"
+#include "queryOverlayDemo.h"
+#include "routeBatch.h"
+#include "searchLimitDemo.h"
+#include "searchMetrics.h"
+#include "sharedGraph.h"
+#include "staticFloor.h"
+#include "vertexOrder.h"
+#include "workBookSnapshot.h"
+#include "tourPlanner.h"
+#include "weightedSearch.h"
 int main(int argc, const char * argv[])
 {
-    runWorkBook();
+    std::string mode = (argc > 1) ? argv[1] : "";
+    if (mode == "tour")
+        runTourPlanner();
+    else if (mode == "weighted")
+        runWeightedSearch();
+    else if (mode == "hierarchy")
+        runHierarchicalPlanner();
+    else if (mode == "landmarks")
+        runLandmarks();
+    else if (mode == "daemon")
+        runPlannerDaemon((argc > 2) ? argv[2] : "/tmp/coffeeRobot.sock", (argc > 3) ? argv[3] : "");
+    else if (mode == "daemon-demo")
+        runPlannerDaemonDemo();
+    else if (mode == "static")
+        runStaticFloor();
+    else if (mode == "kshortest")
+        runKShortestRoutes();
+    else if (mode == "generator")
+        runPathGenerator();
+    else if (mode == "beam")
+        runBeamSearch();
+    else if (mode == "metrics")
+        runSearchMetrics();
+    else if (mode == "generate")
+    {
+        int w = (argc > 3) ? std::atoi(argv[3]) : 1000;
+        int h = (argc > 4) ? std::atoi(argv[4]) : 1000;
+        int coffee = (argc > 5) ? std::atoi(argv[5]) : 4;
+        if (w < 1 || h < 1 || (long long) w * h > INT_MAX || coffee < 1 || coffee > (long long) w * h)
+        {
+            std::cout << "usage: generate <rooms|maze|open|corridors> <width> <height> <coffee> [seed] [file]\n";
+            std::cout << "width and height must be positive with width x height at most " << INT_MAX << ", ";
+            std::cout << "and coffee must be between 1 and width x height.\n";
+            return 1;
+        }
+        runFloorGenerator((argc > 2) ? argv[2] : "", w, h, coffee,
+                          (argc > 6) ? std::strtoull(argv[6], nullptr, 10) : 1,
+                          (argc > 7) ? argv[7] : "");
+    }
+    else if (mode == "rolling")
+        runWorkBookRolling();
+    else if (mode == "one-to-many")
+        runOneToMany();
+    else if (mode == "shared")
+        runSharedGraph();
+    else if (mode == "parallel-build")
+        runParallelBuild();
+    else if (mode == "moves")
+        runMoveString();
+    else if (mode == "batch")
+        runRouteBatch();
+    else if (mode == "vertex-order")
+        runVertexOrder();
+    else if (mode == "anytime")
+        runAnytimePlanner();
+    else if (mode == "overlay")
+        runQueryOverlay();
+    else if (mode == "corridors")
+        runCorridorGraph();
+    else if (mode == "distance-store")
+        runDistanceStore();
+    else if (mode == "battery")
+        runBatteryPlanner();
+    else if (mode == "limits")
+        runSearchLimit();
+    else if (mode == "snapshot")
+        runWorkBookSnapshot();
+    else
+        runWorkBook();
     std::cout << "\nTesting is complete.\n";
     return 0;
 }
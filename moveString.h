@@ -0,0 +1,416 @@
+//  moveString.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Compact routes for robot controllers: a start cell and run-length coded moves.
+
+#ifndef moveString_h
+#define moveString_h
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "floorGenerator.h"
+#include "floorGraph.h"
+#include "weightedSearch.h"
+
+// a route is its start cell and a list of straight runs; each run is one byte,
+// the direction in the top 2 bits and (length - 1) in the low 6 bits, so runs
+// longer than MAX_RUN take several bytes
+//   0 R  x + 1     1 U  y + 1     2 L  x - 1     3 D  y - 1
+// the text form is "x,y R12U3L1" (an empty move list is just "x,y")
+
+class MoveString
+{
+    private: // data elements
+        int startX;
+        int startY;
+        int moves;
+        std::vector<uint8_t> runs;
+
+    public:
+        static constexpr int MAX_RUN = 64;
+        static constexpr int MAX_MOVES = 1 << 28; // longest route parse accepts
+        static constexpr char LETTERS [4] = { 'R', 'U', 'L', 'D' };
+
+    public:
+        MoveString();
+
+    public: // accessors
+        int getStartX() const;
+        int getStartY() const;
+        int getMoveCount() const;
+        int getByteCount() const;
+        const std::vector<uint8_t> & getRuns() const;
+
+    public: // encode
+        void reset(int, int);
+        bool addMove(int, int);
+        void addRun(int, int);
+        bool encode(const FloorGraph &, const std::vector<int> &);
+        bool encode(const Path &);
+
+    public: // decode
+        void decode(std::vector<Vertex> &) const;
+        bool decode(const FloorGraph &, std::vector<int> &) const;
+
+    public: // text form
+        std::string toString() const;
+        bool parse(const std::string &);
+
+    public: // print to console
+        void printMoves() const;
+};
+
+MoveString::MoveString()
+{
+    reset(-1, -1);
+}
+
+int MoveString::getStartX() const
+{
+    return this -> startX;
+}
+
+int MoveString::getStartY() const
+{
+    return this -> startY;
+}
+
+int MoveString::getMoveCount() const
+{
+    return this -> moves;
+}
+
+int MoveString::getByteCount() const
+{
+    return (int) this -> runs.size();
+}
+
+const std::vector<uint8_t> & MoveString::getRuns() const
+{
+    return this -> runs;
+}
+
+void MoveString::reset(int x, int y)
+{
+    this -> startX = x;
+    this -> startY = y;
+    this -> moves = 0;
+    this -> runs.clear();
+}
+
+// one step of (dx, dy); extends the last run when it has the same direction and room
+// returns false unless the step is to one of the four neighbouring cells
+
+bool MoveString::addMove(int dx, int dy)
+{
+    int d;
+    if (dx == 1 && dy == 0)
+        d = 0;
+    else if (dx == 0 && dy == 1)
+        d = 1;
+    else if (dx == -1 && dy == 0)
+        d = 2;
+    else if (dx == 0 && dy == -1)
+        d = 3;
+    else
+        return false;
+
+    if (this -> runs.size() > 0 && (this -> runs.back() >> 6) == d && (this -> runs.back() & 63) < MAX_RUN - 1)
+        this -> runs.back()++;
+    else
+        this -> runs.push_back((uint8_t) (d << 6));
+    this -> moves++;
+    return true;
+}
+
+// length steps in direction d (0 - 3), topping up the last run first
+
+void MoveString::addRun(int d, int length)
+{
+    if (length <= 0)
+        return;
+    this -> moves += length;
+    if (this -> runs.size() > 0 && (this -> runs.back() >> 6) == d)
+    {
+        int room = MAX_RUN - 1 - (this -> runs.back() & 63);
+        int k = std::min(room, length);
+        this -> runs.back() += (uint8_t) k;
+        length -= k;
+    }
+    for (; length > 0; length -= MAX_RUN)
+        this -> runs.push_back((uint8_t) ((d << 6) | (std::min(length, MAX_RUN) - 1)));
+}
+
+// route is a list of vertex ids of g; an empty route gives an empty move string
+// returns false (and leaves the string empty) if two consecutive cells are not neighbours
+
+bool MoveString::encode(const FloorGraph & g, const std::vector<int> & route)
+{
+    reset(-1, -1);
+    if (route.empty())
+        return true;
+    const Vertex & first = g.getVertex(route[0]);
+    reset(first.getX(), first.getY());
+    for (size_t i = 1; i < route.size(); i++)
+    {
+        const Vertex & a = g.getVertex(route[i - 1]);
+        const Vertex & b = g.getVertex(route[i]);
+        if (!addMove(b.getX() - a.getX(), b.getY() - a.getY()))
+        {
+            reset(-1, -1);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MoveString::encode(const Path & p)
+{
+    reset(-1, -1);
+    if (p.getPathSize() == 0)
+        return true;
+    const Vertex * v = p.getPathPtr();
+    reset(v[0].getX(), v[0].getY());
+    for (int i = 1; i < p.getPathSize(); i++)
+        if (!addMove(v[i].getX() - v[i - 1].getX(), v[i].getY() - v[i - 1].getY()))
+        {
+            reset(-1, -1);
+            return false;
+        }
+    return true;
+}
+
+// the cells visited, start included (coordinates only, coffee flags are not stored)
+
+void MoveString::decode(std::vector<Vertex> & cells) const
+{
+    const int dx [4] = { 1, 0, -1, 0 };
+    const int dy [4] = { 0, 1, 0, -1 };
+    cells.clear();
+    if (this -> startX < 0 && this -> startY < 0 && this -> runs.empty())
+        return;
+    cells.reserve(this -> moves + 1);
+    int x = this -> startX;
+    int y = this -> startY;
+    Vertex v;
+    v.setXY(x, y);
+    cells.push_back(v);
+    for (size_t r = 0; r < this -> runs.size(); r++)
+    {
+        int d = this -> runs[r] >> 6;
+        for (int k = (this -> runs[r] & 63) + 1; k > 0; k--)
+        {
+            x += dx[d];
+            y += dy[d];
+            v.setXY(x, y);
+            cells.push_back(v);
+        }
+    }
+}
+
+// the vertex ids of g visited, start included; false if the moves leave the floor
+
+bool MoveString::decode(const FloorGraph & g, std::vector<int> & route) const
+{
+    const int dx [4] = { 1, 0, -1, 0 };
+    const int dy [4] = { 0, 1, 0, -1 };
+    route.clear();
+    if (this -> startX < 0 && this -> startY < 0 && this -> runs.empty())
+        return true;
+    route.reserve(this -> moves + 1);
+    int x = this -> startX;
+    int y = this -> startY;
+    int id = g.findId(x, y);
+    if (id < 0)
+        return false;
+    route.push_back(id);
+    for (size_t r = 0; r < this -> runs.size(); r++)
+    {
+        int d = this -> runs[r] >> 6;
+        for (int k = (this -> runs[r] & 63) + 1; k > 0; k--)
+        {
+            x += dx[d];
+            y += dy[d];
+            id = g.findId(x, y);
+            if (id < 0)
+            {
+                route.clear();
+                return false;
+            }
+            route.push_back(id);
+        }
+    }
+    return true;
+}
+
+// runs split by MAX_RUN are joined again in the text form
+
+std::string MoveString::toString() const
+{
+    std::string rv;
+    if (this -> startX < 0 && this -> startY < 0 && this -> runs.empty())
+        return rv;
+    rv = std::to_string(this -> startX) + "," + std::to_string(this -> startY);
+    if (this -> runs.size() > 0)
+        rv += ' ';
+    size_t r = 0;
+    while (r < this -> runs.size())
+    {
+        int d = this -> runs[r] >> 6;
+        int length = 0;
+        for (; r < this -> runs.size() && (this -> runs[r] >> 6) == d; r++)
+            length += (this -> runs[r] & 63) + 1;
+        rv += LETTERS[d];
+        rv += std::to_string(length);
+    }
+    return rv;
+}
+
+// reads the text form; a missing count means one move ("RRU" is "R2U1")
+// returns false (and leaves the string empty) on malformed input, a count of 0
+// or a route of more than MAX_MOVES moves
+
+bool MoveString::parse(const std::string & text)
+{
+    reset(-1, -1);
+    if (text.empty())
+        return true;
+    const char * p = text.c_str();
+    char * end;
+    long x = std::strtol(p, & end, 10);
+    if (end == p || *end != ',')
+        return false;
+    p = end + 1;
+    long y = std::strtol(p, & end, 10);
+    if (end == p)
+        return false;
+    p = end;
+    reset((int) x, (int) y);
+
+    while (*p == ' ')
+        p++;
+    while (*p != '\0')
+    {
+        int d = -1;
+        for (int i = 0; i < 4; i++)
+            if (*p == LETTERS[i])
+                d = i;
+        if (d < 0)
+        {
+            reset(-1, -1);
+            return false;
+        }
+        p++;
+        long long length = (*p >= '0' && *p <= '9') ? 0 : 1;
+        for (; *p >= '0' && *p <= '9' && length <= MAX_MOVES; p++)
+            length = 10 * length + (*p - '0');
+        if (length < 1 || length > MAX_MOVES - this -> moves)
+        {
+            reset(-1, -1);
+            return false;
+        }
+        addRun(d, (int) length);
+    }
+    return true;
+}
+
+void MoveString::printMoves() const
+{
+    std::cout << "\n{ ";
+    if (this -> startX < 0 && this -> startY < 0 && this -> runs.empty())
+        std::cout << "empty";
+    else
+        std::cout << toString();
+    std::cout << " }";
+}
+
+// a long route on a maze: the vertex list as Path::printPath writes it against
+// the move string, in size and in the time a controller takes to read each back
+
+void runMoveString()
+{
+    std::cout << "Move string testing will start.";
+
+    FloorMap demo = FloorMap::demoFloor();
+    std::vector<Vertex> U;
+    std::vector<Edge> edgeVector;
+    demo.makeEdgesAndVertices(U, edgeVector);
+    FloorGraph small(U, edgeVector);
+    DijkstraPlanner smallPlanner(small);
+    std::vector<int> route;
+    smallPlanner.coffeeRoute(0, small.getVertexCount() - 1, route);
+    MoveString moves;
+    moves.encode(small, route);
+    small.printRoute(route);
+    moves.printMoves();
+
+    FloorMap floor;
+    FloorGenerator::generate("maze", 801, 801, 2, 42, floor);
+    U.clear();
+    edgeVector.clear();
+    floor.makeEdgesAndVertices(U, edgeVector);
+    FloorGraph graph(U, edgeVector);
+    DijkstraPlanner planner(graph);
+    int length = planner.coffeeRoute(0, graph.getVertexCount() - 1, route);
+
+    std::string listText = "{ ";
+    for (size_t i = 0; i < route.size(); i++)
+    {
+        const Vertex & v = graph.getVertex(route[i]);
+        listText += (i > 0) ? ", [ (" : "[ (";
+        listText += std::to_string(v.getX()) + ", " + std::to_string(v.getY()) + "), ";
+        listText += v.getC() ? "c ]" : "n ]";
+    }
+    listText += " }";
+
+    moves.encode(graph, route);
+    std::string moveText = moves.toString();
+
+    // read each form back into moves, as a controller would; the vertex list has
+    // to be turned into steps cell by cell, the move string already is runs
+
+    const int ROUNDS = 20;
+    MoveString fromList;
+    MoveString parsed;
+    int mismatches = 0;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        const char * p = std::strchr(listText.c_str(), '(');
+        char * end;
+        int x = (int) std::strtol(p + 1, & end, 10);
+        int y = (int) std::strtol(end + 1, & end, 10);
+        fromList.reset(x, y);
+        while ((p = std::strchr(end, '(')) != nullptr)
+        {
+            int nx = (int) std::strtol(p + 1, & end, 10);
+            int ny = (int) std::strtol(end + 1, & end, 10);
+            fromList.addMove(nx - x, ny - y);
+            x = nx;
+            y = ny;
+        }
+        mismatches += (fromList.getRuns() != moves.getRuns());
+    }
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        parsed.parse(moveText);
+        mismatches += (parsed.getRuns() != moves.getRuns());
+    }
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+    std::vector<int> decoded;
+    parsed.decode(graph, decoded);
+    mismatches += (decoded != route);
+
+    std::cout << "\nMaze route: " << length << " steps, " << route.size() << " vertices.";
+    std::cout << "\nVertex list: " << listText.size() << " chars, read in ";
+    std::cout << std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() / ROUNDS << " us.";
+    std::cout << "\nMove string: " << moveText.size() << " chars (" << moves.getByteCount() << " bytes packed), read in ";
+    std::cout << std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count() / ROUNDS << " us.";
+    std::cout << "\n" << mismatches << " mismatches.";
+}
+
+#endif /* moveString_h */
@@ -0,0 +1,200 @@
+//  oneToMany.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Coffee route lengths from one start to many targets in one search.
+
+#ifndef oneToMany_h
+#define oneToMany_h
+#include <chrono>
+#include <vector>
+#include "floorGenerator.h"
+#include "floorGraph.h"
+#include "searchLimit.h"
+#include "weightedSearch.h"
+
+// one Dijkstra over the coffee states (v before the coffee, v + V once it is
+// carried) settles every target's v + V state, so each target gets its best
+// station without a search of its own; the search stops as soon as the last
+// requested target is settled, and routes are traced from the kept parents on demand
+
+class OneToManyPlanner
+{
+    private: // data elements
+        const FloorGraph * graph;
+        BucketQueue queue;
+        std::vector<int> dist;
+        std::vector<int> parent;
+        std::vector<char> wanted;
+        int settled;
+
+    public:
+        OneToManyPlanner(const FloorGraph &);
+
+    public: // accessors
+        int getSettledCount() const;
+
+    public: // queries
+        int coffeeDistances(int, const std::vector<int> &, std::vector<int> &);
+        SearchResult coffeeDistances(int, const std::vector<int> &, std::vector<int> &, SearchLimit &);
+        int coffeeRoute(int, std::vector<int> &) const;
+
+    private:
+        int search(int, const std::vector<int> &, std::vector<int> &, SearchLimit *);
+};
+
+OneToManyPlanner::OneToManyPlanner(const FloorGraph & g)
+{
+    this -> graph = & g;
+    this -> settled = 0;
+}
+
+int OneToManyPlanner::getSettledCount() const
+{
+    return this -> settled;
+}
+
+// lengths[i] is the start -> coffee -> targets[i] route length, -1 if there is none
+// returns the number of targets reached
+
+int OneToManyPlanner::coffeeDistances(int start, const std::vector<int> & targets, std::vector<int> & lengths)
+{
+    return search(start, targets, lengths, nullptr);
+}
+
+// under a deadline or cancellation token; targets settled before the search was
+// cut short keep their (final) lengths, the rest stay -1
+// the result's length is the number of targets reached
+
+SearchResult OneToManyPlanner::coffeeDistances(int start, const std::vector<int> & targets, std::vector<int> & lengths, SearchLimit & limit)
+{
+    return limit.finish(search(start, targets, lengths, & limit));
+}
+
+// limit is nullptr for an unrestricted search, else checked per state settled
+
+int OneToManyPlanner::search(int start, const std::vector<int> & targets, std::vector<int> & lengths, SearchLimit * limit)
+{
+    int vCount = this -> graph -> getVertexCount();
+    lengths.assign(targets.size(), -1);
+    this -> dist.assign(2 * vCount, -1);
+    this -> parent.assign(2 * vCount, -1);
+    this -> wanted.assign(vCount, 0);
+    this -> settled = 0;
+    if (start < 0 || start >= vCount)
+        return 0;
+
+    int pending = 0;
+    for (size_t i = 0; i < targets.size(); i++)
+        if (targets[i] >= 0 && targets[i] < vCount && !this -> wanted[targets[i]])
+        {
+            this -> wanted[targets[i]] = 1;
+            pending++;
+        }
+
+    int source = start + (this -> graph -> getVertex(start).getC() ? vCount : 0);
+    this -> queue.setMaxWeight(this -> graph -> getMaxWeight());
+    this -> dist[source] = 0;
+    this -> queue.push(source, 0);
+
+    int u;
+    int key;
+    while (pending > 0 && this -> queue.pop(u, key))
+    {
+        if (key != this -> dist[u])
+            continue;
+        if (limit != nullptr && limit -> shouldStop())
+            break;
+        this -> settled++;
+        if (u >= vCount && this -> wanted[u - vCount])
+        {
+            this -> wanted[u - vCount] = 0;
+            pending--;
+        }
+
+        int layer = (u >= vCount) ? vCount : 0;
+        int pivot = u - layer;
+        for (int e = this -> graph -> getFirstEdge(pivot); e < this -> graph -> getLastEdge(pivot); e++)
+        {
+            int v = this -> graph -> getTarget(e);
+            int next = v + ((layer > 0 || this -> graph -> getVertex(v).getC()) ? vCount : 0);
+            int nd = key + this -> graph -> getWeight(e);
+            if (this -> dist[next] < 0 || nd < this -> dist[next])
+            {
+                this -> dist[next] = nd;
+                this -> parent[next] = u;
+                this -> queue.push(next, nd);
+            }
+        }
+    }
+
+    // a target still pending was never settled, so its tentative distance is not final
+
+    int rv = 0;
+    for (size_t i = 0; i < targets.size(); i++)
+        if (targets[i] >= 0 && targets[i] < vCount && !this -> wanted[targets[i]] && this -> dist[targets[i] + vCount] >= 0)
+        {
+            lengths[i] = this -> dist[targets[i] + vCount];
+            rv++;
+        }
+    return rv;
+}
+
+// the route to one target of the last coffeeDistances call; returns its length or -1
+
+int OneToManyPlanner::coffeeRoute(int target, std::vector<int> & route) const
+{
+    route.clear();
+    int vCount = this -> graph -> getVertexCount();
+    if (target < 0 || target >= vCount || (int) this -> dist.size() != 2 * vCount ||
+        this -> wanted[target] || this -> dist[target + vCount] < 0)
+        return -1;
+    for (int s = target + vCount; s >= 0; s = this -> parent[s])
+        route.push_back(s % vCount);
+    std::reverse(route.begin(), route.end());
+    return this -> dist[target + vCount];
+}
+
+void runOneToMany()
+{
+    std::cout << "One-to-many testing will start.";
+
+    FloorMap floor;
+    FloorGenerator::generate("rooms", 600, 600, 4, 39, floor);
+    std::vector<Vertex> U;
+    std::vector<Edge> edgeVector;
+    floor.makeEdgesAndVertices(U, edgeVector);
+    FloorGraph graph(U, edgeVector);
+
+    // every desk is a random open cell
+
+    const int DESKS = 200;
+    FloorGenerator desks(7);
+    std::vector<int> targets;
+    for (int i = 0; i < DESKS; i++)
+        targets.push_back(desks.below(graph.getVertexCount()));
+    int start = desks.below(graph.getVertexCount());
+
+    OneToManyPlanner planner(graph);
+    std::vector<int> lengths;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    int reached = planner.coffeeDistances(start, targets, lengths);
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+    DijkstraPlanner single(graph);
+    std::vector<int> route;
+    int mismatches = 0;
+    for (int i = 0; i < DESKS; i++)
+        if (single.coffeeRoute(start, targets[i], route) != lengths[i])
+            mismatches++;
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+    std::cout << "\n" << graph.getVertexCount() << " vertices, " << DESKS << " desks, " << reached << " reached.";
+    std::cout << "\nOne pass: " << std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() << " us.";
+    std::cout << "\nOne search per desk: " << std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count() << " us, ";
+    std::cout << mismatches << " mismatches.";
+
+    int length = planner.coffeeRoute(targets[0], route);
+    std::cout << "\nRoute to the first desk: " << length << " steps, " << route.size() << " vertices.";
+}
+
+#endif /* oneToMany_h */
@@ -0,0 +1,220 @@
+//  parallelBuild.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Multi-threaded FloorGraph construction straight from a FloorMap.
+
+#ifndef parallelBuild_h
+#define parallelBuild_h
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+#include "floorGenerator.h"
+#include "floorGraph.h"
+#include "floorMap.h"
+
+// builds the same graph as FloorGraph(U, edgeVector) after FloorMap::makeEdgesAndVertices
+// (equal fingerprint), without the intermediate Vertex and Edge vectors:
+//   1. per column: open cells, lowest and highest open row (columns split across threads)
+//   2. prefix sum over columns gives every column its first vertex id
+//   3. per column: vertices, the (x, y) -> id table and each vertex's degree
+//   4. parallel prefix sum over the degrees gives the adjacency offsets
+//   5. per column: targets and weights, written straight into their final slots
+// a vertex lists its neighbours left, down, up, right, which is the order the
+// edge pairs are appended by makeEdgesAndVertices
+
+class ParallelGraphBuilder
+{
+    public:
+        static void build(const FloorMap &, FloorGraph &, int);
+
+    private:
+        static void parallelFor(int, int, const std::function<void(int, int, int)> &);
+        static void prefixSum(std::vector<int> &, int);
+};
+
+// runs work(begin, end, thread) over [0, count) cut into one contiguous range per thread
+
+void ParallelGraphBuilder::parallelFor(int count, int threads, const std::function<void(int, int, int)> & work)
+{
+    threads = std::max(1, std::min(threads, count));
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; t++)
+        workers.push_back(std::thread(work, (int) ((long long) count * t / threads), (int) ((long long) count * (t + 1) / threads), t));
+    if (count > 0)
+        work(0, (int) ((long long) count / threads), 0);
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+}
+
+// exclusive prefix sum in place: each thread sums its block, the block totals are
+// scanned, then each thread rescans its block from its base
+
+void ParallelGraphBuilder::prefixSum(std::vector<int> & values, int threads)
+{
+    int count = (int) values.size();
+    threads = std::max(1, std::min(threads, count));
+    std::vector<long long> totals(threads + 1, 0);
+    parallelFor(count, threads, [&values, &totals](int begin, int end, int t)
+    {
+        long long sum = 0;
+        for (int i = begin; i < end; i++)
+            sum += values[i];
+        totals[t + 1] = sum;
+    });
+    for (int t = 0; t < threads; t++)
+        totals[t + 1] += totals[t];
+    parallelFor(count, threads, [&values, &totals](int begin, int end, int t)
+    {
+        long long running = totals[t];
+        for (int i = begin; i < end; i++)
+        {
+            int value = values[i];
+            values[i] = (int) running;
+            running += value;
+        }
+    });
+}
+
+void ParallelGraphBuilder::build(const FloorMap & map, FloorGraph & graph, int threads)
+{
+    int mapWidth = map.getWidth();
+    int mapHeight = map.getHeight();
+    threads = std::max(1, threads);
+
+    // 1. columns
+
+    std::vector<int> columnBase(mapWidth + 1, 0);
+    std::vector<int> columnLow(mapWidth, mapHeight);
+    std::vector<int> columnHigh(mapWidth, -1);
+    parallelFor(mapWidth, threads, [&](int begin, int end, int)
+    {
+        for (int x = begin; x < end; x++)
+            for (int y = 0; y < mapHeight; y++)
+                if (map.isOpen(x, y))
+                {
+                    columnBase[x]++;
+                    columnLow[x] = std::min(columnLow[x], y);
+                    columnHigh[x] = y;
+                }
+    });
+
+    // 2. column ids and the bounding box of the open cells
+
+    prefixSum(columnBase, threads);
+    int vCount = columnBase[mapWidth];
+    graph.minX = 0;
+    graph.minY = 0;
+    graph.width = 0;
+    graph.height = 0;
+    graph.maxWeight = 1;
+    if (vCount > 0)
+    {
+        int maxX = 0;
+        int maxY = 0;
+        graph.minX = mapWidth;
+        graph.minY = mapHeight;
+        for (int x = 0; x < mapWidth; x++)
+            if (columnHigh[x] >= 0)
+            {
+                graph.minX = std::min(graph.minX, x);
+                maxX = x;
+                graph.minY = std::min(graph.minY, columnLow[x]);
+                maxY = std::max(maxY, columnHigh[x]);
+            }
+        graph.width = maxX - graph.minX + 1;
+        graph.height = maxY - graph.minY + 1;
+    }
+
+    // 3. vertices, lookup table and degrees
+
+    graph.vertices.assign(vCount, Vertex());
+    graph.cells.assign((size_t) graph.width * graph.height, -1);
+    graph.offsets.assign(vCount + 1, 0);
+    parallelFor(mapWidth, threads, [&](int begin, int end, int)
+    {
+        for (int x = begin; x < end; x++)
+        {
+            int id = columnBase[x];
+            for (int y = 0; y < mapHeight; y++)
+            {
+                if (!map.isOpen(x, y))
+                    continue;
+                graph.vertices[id].setXY(x, y);
+                if (map.isCoffee(x, y))
+                    graph.vertices[id].placeC();
+                graph.cells[(size_t) (y - graph.minY) * graph.width + (x - graph.minX)] = id;
+                graph.offsets[id] = map.isOpen(x - 1, y) + map.isOpen(x, y - 1) + map.isOpen(x, y + 1) + map.isOpen(x + 1, y);
+                id++;
+            }
+        }
+    });
+
+    // 4. offsets
+
+    prefixSum(graph.offsets, threads);
+    int eCount = graph.offsets[vCount];
+
+    // 5. adjacency
+
+    graph.targets.assign(eCount, -1);
+    graph.weights.assign(eCount, 1);
+    std::vector<int> heaviest(threads, 1);
+    parallelFor(mapWidth, threads, [&](int begin, int end, int t)
+    {
+        const int dx [4] = { -1, 0, 0, 1 };
+        const int dy [4] = { 0, -1, 1, 0 };
+        for (int x = begin; x < end; x++)
+            for (int y = 0; y < mapHeight; y++)
+            {
+                if (!map.isOpen(x, y))
+                    continue;
+                int id = graph.cells[(size_t) (y - graph.minY) * graph.width + (x - graph.minX)];
+                int e = graph.offsets[id];
+                for (int d = 0; d < 4; d++)
+                {
+                    int nx = x + dx[d];
+                    int ny = y + dy[d];
+                    if (!map.isOpen(nx, ny))
+                        continue;
+                    int w = std::max(map.getCost(x, y), map.getCost(nx, ny));
+                    graph.targets[e] = graph.cells[(size_t) (ny - graph.minY) * graph.width + (nx - graph.minX)];
+                    graph.weights[e] = w;
+                    heaviest[t] = std::max(heaviest[t], w);
+                    e++;
+                }
+            }
+    });
+    for (int t = 0; t < threads; t++)
+        graph.maxWeight = std::max(graph.maxWeight, heaviest[t]);
+}
+
+void runParallelBuild()
+{
+    std::cout << "Parallel graph build will start.";
+
+    FloorMap floor;
+    FloorGenerator::generate("rooms", 2000, 2000, 8, 41, floor);
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    std::vector<Vertex> U;
+    std::vector<Edge> edgeVector;
+    floor.makeEdgesAndVertices(U, edgeVector);
+    FloorGraph sequential(U, edgeVector);
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    std::cout << "\n" << sequential.getVertexCount() << " vertices, " << sequential.getEdgeCount() << " directed edges.";
+    std::cout << "\nmakeEdgesAndVertices + FloorGraph: " << std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count() << " ms.";
+
+    int cores = std::max(1, (int) std::thread::hardware_concurrency());
+    for (int threads = 1; threads <= std::max(4, cores); threads *= 2)
+    {
+        FloorGraph parallel;
+        std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+        ParallelGraphBuilder::build(floor, parallel, threads);
+        std::chrono::steady_clock::time_point t3 = std::chrono::steady_clock::now();
+        std::cout << "\n" << threads << " threads: " << std::chrono::duration_cast<std::chrono::milliseconds>(t3 - t2).count() << " ms, ";
+        std::cout << ((parallel.fingerprint() == sequential.fingerprint()) ? "same graph." : "different graph.");
+    }
+}
+
+#endif /* parallelBuild_h */
@@ -0,0 +1,250 @@
+//  pathGenerator.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Lazy, unpruned breadth-order path enumeration with C++20 coroutines.
+
+#ifndef pathGenerator_h
+#define pathGenerator_h
+#include <chrono>
+#include <vector>
+#include "floorGraph.h"
+#include "floorMap.h"
+#include "searchLimit.h"
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#include <coroutine>
+#include <utility>
+
+// a generator yields a reference to its current path, valid until the next call to next()
+// destroying the generator (e.g. leaving the loop early) releases its frame at once
+
+class PathGenerator
+{
+    public:
+        struct promise_type
+        {
+            const std::vector<int> * current = nullptr;
+
+            PathGenerator get_return_object() { return PathGenerator(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            std::suspend_always yield_value(const std::vector<int> & path) noexcept { this -> current = & path; return {}; }
+            void return_void() {}
+            void unhandled_exception() { throw; }
+        };
+
+    private: // data elements
+        std::coroutine_handle<promise_type> handle;
+
+    public:
+        explicit PathGenerator(std::coroutine_handle<promise_type>);
+        PathGenerator(PathGenerator &&) noexcept;
+        PathGenerator(const PathGenerator &) = delete;
+        PathGenerator & operator=(const PathGenerator &) = delete;
+        ~PathGenerator();
+
+    public:
+        bool next();
+        const std::vector<int> & path() const;
+
+    public: // generators and consumers
+        static PathGenerator breadthPaths(const FloorGraph &, int, int);
+        static bool isCoffeeRoute(const FloorGraph &, const std::vector<int> &, int);
+        static int firstCoffeeRoute(const FloorGraph &, int, int, int, std::vector<int> &, long long &);
+        static SearchResult firstCoffeeRoute(const FloorGraph &, int, int, int, std::vector<int> &, long long &, SearchLimit &);
+
+    private:
+        static int search(const FloorGraph &, int, int, int, std::vector<int> &, long long &, SearchLimit *);
+};
+
+PathGenerator::PathGenerator(std::coroutine_handle<promise_type> h)
+{
+    this -> handle = h;
+}
+
+PathGenerator::PathGenerator(PathGenerator && right) noexcept
+{
+    this -> handle = std::exchange(right.handle, nullptr);
+}
+
+PathGenerator::~PathGenerator()
+{
+    if (this -> handle)
+        this -> handle.destroy();
+}
+
+// resumes the search; false once every path has been yielded
+
+bool PathGenerator::next()
+{
+    if (!this -> handle || this -> handle.done())
+        return false;
+    this -> handle.resume();
+    return !this -> handle.done();
+}
+
+const std::vector<int> & PathGenerator::path() const
+{
+    return *(this -> handle.promise().current);
+}
+
+// every simple path from start by size, then by parent, then by neighbour order
+// (breadth order over a tree is the depth-first order of each level, so each level
+// is re-walked depth-first instead of stored)
+// this is a separate enumerator, not WorkBook's: it has no ex/fr pruning and no
+// findPath deduplication, both of which need the whole previous or current level,
+// so it yields far more paths (20472 before the demo route, where WorkBook's last
+// level holds 166) and their number grows exponentially with the floor
+// paths are simple over (vertex, coffee carried) states, so a route may come back
+// along the corridor it used to reach a coffee station
+// memory is one path and one edge cursor per step, whatever the level holds
+
+PathGenerator PathGenerator::breadthPaths(const FloorGraph & graph, int start, int maxSize)
+{
+    int vCount = graph.getVertexCount();
+    if (start < 0 || start >= vCount || maxSize < 1)
+        co_return;
+
+    std::vector<int> path(1, start);
+    std::vector<int> states(1, start + (graph.getVertex(start).getC() ? vCount : 0));
+    std::vector<int> cursor;
+    std::vector<char> onPath(2 * vCount, 0);
+    onPath[states[0]] = 1;
+    co_yield path;
+
+    for (int size = 2; size <= maxSize; size++)
+    {
+        bool any = false;
+        cursor.assign(1, graph.getFirstEdge(start));
+        while (!cursor.empty())
+        {
+            int u = path.back();
+            if (cursor.back() == graph.getLastEdge(u))
+            {
+                cursor.pop_back();
+                if (cursor.empty())
+                    break;
+                onPath[states.back()] = 0;
+                path.pop_back();
+                states.pop_back();
+                cursor.back()++;
+                continue;
+            }
+
+            int v = graph.getTarget(cursor.back());
+            int state = v + ((states.back() >= vCount || graph.getVertex(v).getC()) ? vCount : 0);
+            if (onPath[state])
+            {
+                cursor.back()++;
+                continue;
+            }
+            path.push_back(v);
+            states.push_back(state);
+            if ((int) path.size() == size)
+            {
+                any = true;
+                co_yield path;
+                path.pop_back();
+                states.pop_back();
+                cursor.back()++;
+            }
+            else
+            {
+                onPath[state] = 1;
+                cursor.push_back(graph.getFirstEdge(v));
+            }
+        }
+        if (!any)
+            co_return;
+    }
+}
+
+// the goal test for a single path: coffee picked up, then the goal reached at its end
+// (WorkBook accepts the goal anywhere on a coffee path)
+
+bool PathGenerator::isCoffeeRoute(const FloorGraph & graph, const std::vector<int> & path, int goal)
+{
+    if (path.empty() || path.back() != goal)
+        return false;
+    for (size_t i = 0; i < path.size(); i++)
+        if (graph.getVertex(path[i]).getC())
+            return true;
+    return false;
+}
+
+// runs the goal test as each path is yielded and stops at the first coffee route,
+// which is a fewest-steps one; returns its size, or -1 if none has at most maxSize vertices
+
+int PathGenerator::firstCoffeeRoute(const FloorGraph & graph, int start, int goal, int maxSize, std::vector<int> & route, long long & yielded)
+{
+    return search(graph, start, goal, maxSize, route, yielded, nullptr);
+}
+
+// under a deadline or cancellation token; a search cut short returns no route
+// the result's length is the route size in vertices, as above
+
+SearchResult PathGenerator::firstCoffeeRoute(const FloorGraph & graph, int start, int goal, int maxSize, std::vector<int> & route, long long & yielded, SearchLimit & limit)
+{
+    return limit.finish(search(graph, start, goal, maxSize, route, yielded, & limit));
+}
+
+// limit is nullptr for an unrestricted search; it is checked per path yielded
+// and once as each new path size begins, and leaving early destroys the generator
+
+int PathGenerator::search(const FloorGraph & graph, int start, int goal, int maxSize, std::vector<int> & route, long long & yielded, SearchLimit * limit)
+{
+    route.clear();
+    yielded = 0;
+    size_t level = 0;
+    PathGenerator paths = breadthPaths(graph, start, maxSize);
+    while (paths.next())
+    {
+        if (limit != nullptr && paths.path().size() > level)
+        {
+            level = paths.path().size();
+            if (limit -> checkNow())
+                return -1;
+        }
+        else if (limit != nullptr && limit -> shouldStop())
+            return -1;
+        yielded++;
+        if (isCoffeeRoute(graph, paths.path(), goal))
+        {
+            route = paths.path();
+            return (int) route.size();
+        }
+    }
+    return -1;
+}
+
+void runPathGenerator()
+{
+    std::cout << "Path generator testing will start.";
+
+    FloorMap floor = FloorMap::demoFloor();
+    std::vector<Vertex> U;
+    std::vector<Edge> edgeVector;
+    floor.makeEdgesAndVertices(U, edgeVector);
+    FloorGraph graph(U, edgeVector);
+
+    std::vector<int> route;
+    long long yielded = 0;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    int size = PathGenerator::firstCoffeeRoute(graph, graph.findId(3, 2), graph.findId(3, 4), 25, route, yielded);
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+    std::cout << "\nCoffee route of " << size << " vertices after " << yielded << " paths:";
+    graph.printRoute(route);
+    std::cout << "\nSearch time: " << std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() << " us.";
+}
+
+#else
+
+void runPathGenerator()
+{
+    std::cout << "Path generator testing needs a C++20 compiler with coroutines (-std=c++20).";
+}
+
+#endif
+
+#endif /* pathGenerator_h */
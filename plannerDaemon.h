@@ -0,0 +1,643 @@
+//  plannerDaemon.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Long-running planner: one map, route queries over a Unix domain socket.
+
+#ifndef plannerDaemon_h
+#define plannerDaemon_h
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "floorGraph.h"
+#include "floorMap.h"
+#include "moveString.h"
+#include "searchLimit.h"
+#include "weightedSearch.h"
+
+// line protocol, one request per line, answers in request order per connection
+// (clients may pipeline any number of requests before reading)
+//   PING                  ->  PONG
+//   ROUTE sx sy gx gy     ->  OK <length> x,y x,y ...   start -> coffee -> goal
+//   PATH sx sy gx gy      ->  OK <length> x,y x,y ...   plain shortest path
+//   MOVES sx sy gx gy     ->  OK <length> x,y R12U3 ...  ROUTE as a move string (moveString.h)
+//                             NONE if there is no route, ERR <reason> for bad input,
+//                             TIMEOUT <steps> if the request budget ran out first,
+//                             CANCELLED if the daemon stopped during the search
+// the budget runs from the moment the request line was read, so time spent
+// queued behind other requests counts against it
+//
+// one event loop thread does all socket I/O (non-blocking, epoll); workers solve
+// queries against the shared read-only graph and hand answers back through an eventfd
+
+class PlannerDaemon
+{
+    private: // per connection state, owned by the event loop
+        class Connection
+        {
+            public:
+                int fd;
+                std::string input;
+                std::string output;
+                long long nextSeq = 0;
+                long long nextToSend = 0;
+                std::map<long long, std::string> ready;
+                bool watchingOutput = false;
+                bool peerClosed = false;
+        };
+
+        class Task
+        {
+            public:
+                long long connection;
+                long long seq;
+                std::string request;
+                std::chrono::steady_clock::time_point received;
+        };
+
+    private: // data elements
+        const FloorGraph * graph;
+        std::string socketPath;
+        int listenFd;
+        int epollFd;
+        int wakeFd;
+        std::atomic<bool> running;
+        std::map<long long, Connection> connections;
+        std::map<int, long long> connectionOfFd;
+        long long nextConnection;
+        std::vector<std::thread> workers;
+        long long budgetMicroseconds;
+        CancelToken cancel;
+
+    private: // worker hand-off
+        std::mutex taskMutex;
+        std::condition_variable taskReady;
+        std::deque<Task> tasks;
+        std::mutex doneMutex;
+        std::vector<Task> done;
+
+    public: // longest accepted request line
+        static constexpr size_t MAX_LINE = 1024;
+
+    public:
+        PlannerDaemon(const FloorGraph &, const std::string &);
+        ~PlannerDaemon();
+
+    public:
+        void setBudget(long long);
+        bool start(int);
+        void run();
+        void stop();
+
+    public: // request handling, also usable without a socket
+        static std::string answer(const FloorGraph &, DijkstraPlanner &, const std::string &);
+        static std::string answer(const FloorGraph &, DijkstraPlanner &, const std::string &, SearchLimit &);
+
+    private:
+        void acceptConnections();
+        void readConnection(long long);
+        void flushConnection(long long);
+        void closeConnection(long long);
+        void updateEvents(Connection &);
+        void collectAnswers();
+        void wakeWorkers();
+        void workerLoop();
+};
+
+PlannerDaemon::PlannerDaemon(const FloorGraph & g, const std::string & path)
+{
+    this -> graph = & g;
+    this -> socketPath = path;
+    this -> listenFd = -1;
+    this -> epollFd = -1;
+    this -> wakeFd = -1;
+    this -> running = false;
+    this -> nextConnection = 0;
+    this -> budgetMicroseconds = 0;
+}
+
+PlannerDaemon::~PlannerDaemon()
+{
+    stop();
+    wakeWorkers();
+    for (size_t i = 0; i < this -> workers.size(); i++)
+        this -> workers[i].join();
+    std::map<long long, Connection>::iterator it;
+    for (it = this -> connections.begin(); it != this -> connections.end(); it++)
+        close(it -> second.fd);
+    if (this -> listenFd >= 0)
+    {
+        close(this -> listenFd);
+        unlink(this -> socketPath.c_str());
+    }
+    if (this -> epollFd >= 0)
+        close(this -> epollFd);
+    if (this -> wakeFd >= 0)
+        close(this -> wakeFd);
+}
+
+// per request latency budget in microseconds (0, the default, for none); set before start()
+
+void PlannerDaemon::setBudget(long long microseconds)
+{
+    this -> budgetMicroseconds = std::max(0LL, microseconds);
+}
+
+// binds the socket and starts the workers; returns false if the socket cannot be set up
+
+bool PlannerDaemon::start(int workerCount)
+{
+    this -> cancel.reset();
+    sockaddr_un address;
+    std::memset(& address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (this -> socketPath.size() >= sizeof(address.sun_path))
+        return false;
+    std::strcpy(address.sun_path, this -> socketPath.c_str());
+
+    unlink(this -> socketPath.c_str());
+    this -> listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (this -> listenFd < 0 ||
+        bind(this -> listenFd, (sockaddr *) & address, sizeof(address)) < 0 ||
+        listen(this -> listenFd, 128) < 0)
+        return false;
+
+    this -> epollFd = epoll_create1(EPOLL_CLOEXEC);
+    this -> wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (this -> epollFd < 0 || this -> wakeFd < 0)
+        return false;
+
+    epoll_event event;
+    std::memset(& event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = this -> listenFd;
+    epoll_ctl(this -> epollFd, EPOLL_CTL_ADD, this -> listenFd, & event);
+    event.data.fd = this -> wakeFd;
+    epoll_ctl(this -> epollFd, EPOLL_CTL_ADD, this -> wakeFd, & event);
+
+    this -> running = true;
+    workerCount = std::max(1, workerCount);
+    for (int i = 0; i < workerCount; i++)
+        this -> workers.push_back(std::thread(& PlannerDaemon::workerLoop, this));
+    return true;
+}
+
+// event loop; returns after stop()
+
+void PlannerDaemon::run()
+{
+    const int EVENTS = 64;
+    epoll_event events [EVENTS];
+    while (this -> running)
+    {
+        int count = epoll_wait(this -> epollFd, events, EVENTS, 200);
+        for (int i = 0; i < count; i++)
+        {
+            int fd = events[i].data.fd;
+            if (fd == this -> listenFd)
+                acceptConnections();
+            else if (fd == this -> wakeFd)
+                collectAnswers();
+            else
+            {
+                std::map<int, long long>::iterator it = this -> connectionOfFd.find(fd);
+                if (it == this -> connectionOfFd.end())
+                    continue;
+                long long id = it -> second;
+                if (events[i].events & (EPOLLHUP | EPOLLERR))
+                    closeConnection(id);
+                else
+                {
+                    if (events[i].events & EPOLLIN)
+                        readConnection(id);
+                    if ((events[i].events & EPOLLOUT) && this -> connections.count(id))
+                        flushConnection(id);
+                }
+            }
+        }
+    }
+    wakeWorkers();
+}
+
+// only touches atomic flags and the eventfd, so it is safe in a signal handler;
+// searches in progress see the cancelled token and give up
+
+void PlannerDaemon::stop()
+{
+    this -> running = false;
+    this -> cancel.cancel();
+    if (this -> wakeFd >= 0)
+    {
+        uint64_t one = 1;
+        ssize_t rc = write(this -> wakeFd, & one, sizeof(one));
+        (void) rc;
+    }
+}
+
+void PlannerDaemon::acceptConnections()
+{
+    for (;;)
+    {
+        int fd = accept4(this -> listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            return;
+        long long id = this -> nextConnection++;
+        this -> connections[id].fd = fd;
+        this -> connectionOfFd[fd] = id;
+
+        epoll_event event;
+        std::memset(& event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(this -> epollFd, EPOLL_CTL_ADD, fd, & event);
+    }
+}
+
+// every complete line becomes one task; partial lines wait for more input
+
+void PlannerDaemon::readConnection(long long id)
+{
+    Connection & c = this -> connections[id];
+    char buffer [4096];
+    bool closed = false;
+    bool tooLong = false;
+    for (;;)
+    {
+        ssize_t n = read(c.fd, buffer, sizeof(buffer));
+        if (n > 0)
+            c.input.append(buffer, (size_t) n);
+        else
+        {
+            if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+                closed = true;
+            break;
+        }
+    }
+
+    std::vector<Task> batch;
+    size_t begin = 0;
+    size_t end;
+    while ((end = c.input.find('\n', begin)) != std::string::npos)
+    {
+        Task t;
+        t.connection = id;
+        t.seq = c.nextSeq++;
+        t.request = c.input.substr(begin, end - begin);
+        t.received = std::chrono::steady_clock::now();
+        batch.push_back(t);
+        begin = end + 1;
+    }
+    c.input.erase(0, begin);
+    if (c.input.size() > MAX_LINE)
+        tooLong = true;
+
+    if (batch.size() > 0)
+    {
+        std::lock_guard<std::mutex> lock(this -> taskMutex);
+        this -> tasks.insert(this -> tasks.end(), batch.begin(), batch.end());
+    }
+    if (batch.size() == 1)
+        this -> taskReady.notify_one();
+    else if (batch.size() > 1)
+        this -> taskReady.notify_all();
+
+    // a client that hung up still gets the answers to what it sent
+
+    if (tooLong || (closed && c.nextToSend == c.nextSeq && c.output.empty()))
+        closeConnection(id);
+    else if (closed)
+    {
+        c.peerClosed = true;
+        updateEvents(c);
+    }
+}
+
+// writes answers in sequence order as far as they are ready
+
+void PlannerDaemon::flushConnection(long long id)
+{
+    Connection & c = this -> connections[id];
+    std::map<long long, std::string>::iterator it = c.ready.begin();
+    while (it != c.ready.end() && it -> first == c.nextToSend)
+    {
+        c.output += it -> second;
+        c.nextToSend++;
+        it = c.ready.erase(it);
+    }
+
+    while (!c.output.empty())
+    {
+        ssize_t n = send(c.fd, c.output.data(), c.output.size(), MSG_NOSIGNAL);
+        if (n > 0)
+            c.output.erase(0, (size_t) n);
+        else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        else
+        {
+            closeConnection(id);
+            return;
+        }
+    }
+
+    if (c.peerClosed && c.output.empty() && c.nextToSend == c.nextSeq)
+        closeConnection(id);
+    else if (c.watchingOutput != !c.output.empty())
+        updateEvents(c);
+}
+
+void PlannerDaemon::updateEvents(Connection & c)
+{
+    c.watchingOutput = !c.output.empty();
+    epoll_event event;
+    std::memset(& event, 0, sizeof(event));
+    event.events = (c.peerClosed ? 0u : (uint32_t) EPOLLIN) | (c.watchingOutput ? (uint32_t) EPOLLOUT : 0u);
+    event.data.fd = c.fd;
+    epoll_ctl(this -> epollFd, EPOLL_CTL_MOD, c.fd, & event);
+}
+
+void PlannerDaemon::closeConnection(long long id)
+{
+    std::map<long long, Connection>::iterator it = this -> connections.find(id);
+    if (it == this -> connections.end())
+        return;
+    epoll_ctl(this -> epollFd, EPOLL_CTL_DEL, it -> second.fd, nullptr);
+    close(it -> second.fd);
+    this -> connectionOfFd.erase(it -> second.fd);
+    this -> connections.erase(it);
+}
+
+void PlannerDaemon::collectAnswers()
+{
+    uint64_t count;
+    ssize_t rc = read(this -> wakeFd, & count, sizeof(count));
+    (void) rc;
+
+    std::vector<Task> batch;
+    {
+        std::lock_guard<std::mutex> lock(this -> doneMutex);
+        batch.swap(this -> done);
+    }
+
+    std::vector<long long> touched;
+    for (size_t i = 0; i < batch.size(); i++)
+    {
+        std::map<long long, Connection>::iterator it = this -> connections.find(batch[i].connection);
+        if (it == this -> connections.end())
+            continue;
+        it -> second.ready[batch[i].seq] = batch[i].request;
+        touched.push_back(batch[i].connection);
+    }
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+    for (size_t i = 0; i < touched.size(); i++)
+        if (this -> connections.count(touched[i]))
+            flushConnection(touched[i]);
+}
+
+// taking the lock first means a worker cannot miss the wake-up between its check and its wait
+
+void PlannerDaemon::wakeWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(this -> taskMutex);
+    }
+    this -> taskReady.notify_all();
+}
+
+// each worker owns its search scratch; the graph is only read
+
+void PlannerDaemon::workerLoop()
+{
+    DijkstraPlanner planner(*(this -> graph));
+    for (;;)
+    {
+        Task t;
+        {
+            std::unique_lock<std::mutex> lock(this -> taskMutex);
+            this -> taskReady.wait(lock, [this]() { return !this -> running || !this -> tasks.empty(); });
+            if (!this -> running)
+                return;
+            t = this -> tasks.front();
+            this -> tasks.pop_front();
+        }
+
+        if (this -> budgetMicroseconds > 0)
+        {
+            SearchLimit limit(t.received + std::chrono::microseconds(this -> budgetMicroseconds), this -> cancel);
+            t.request = answer(*(this -> graph), planner, t.request, limit);
+        }
+        else
+        {
+            SearchLimit limit(this -> cancel);
+            t.request = answer(*(this -> graph), planner, t.request, limit);
+        }
+
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lock(this -> doneMutex);
+            wake = this -> done.empty();
+            this -> done.push_back(t);
+        }
+        if (wake)
+        {
+            uint64_t one = 1;
+            ssize_t rc = write(this -> wakeFd, & one, sizeof(one));
+            (void) rc;
+        }
+    }
+}
+
+std::string PlannerDaemon::answer(const FloorGraph & g, DijkstraPlanner & planner, const std::string & request)
+{
+    SearchLimit none;
+    return answer(g, planner, request, none);
+}
+
+std::string PlannerDaemon::answer(const FloorGraph & g, DijkstraPlanner & planner, const std::string & request, SearchLimit & limit)
+{
+    std::istringstream in(request);
+    std::string command;
+    in >> command;
+    if (command == "PING")
+        return "PONG\n";
+    if (command != "ROUTE" && command != "PATH" && command != "MOVES")
+        return "ERR unknown command\n";
+
+    int sx;
+    int sy;
+    int gx;
+    int gy;
+    if (!(in >> sx >> sy >> gx >> gy))
+        return "ERR expected sx sy gx gy\n";
+    int start = g.findId(sx, sy);
+    int goal = g.findId(gx, gy);
+    if (start < 0 || goal < 0)
+        return "ERR no such cell\n";
+
+    std::vector<int> route;
+    SearchResult result;
+    if (command == "ROUTE" || command == "MOVES")
+        result = planner.coffeeRoute(start, goal, route, limit);
+    else
+        result = planner.shortestPath(start, goal, route, limit);
+    if (result.status == SearchStatus::EXPIRED)
+        return "TIMEOUT " + std::to_string(result.steps) + "\n";
+    if (result.status == SearchStatus::CANCELLED)
+        return "CANCELLED\n";
+    if (result.status == SearchStatus::NOT_FOUND)
+        return "NONE\n";
+
+    std::string rv = "OK " + std::to_string(result.length);
+    if (command == "MOVES")
+    {
+        MoveString moves;
+        moves.encode(g, route);
+        return rv + " " + moves.toString() + "\n";
+    }
+    for (size_t i = 0; i < route.size(); i++)
+    {
+        const Vertex & v = g.getVertex(route[i]);
+        rv += ' ';
+        rv += std::to_string(v.getX());
+        rv += ',';
+        rv += std::to_string(v.getY());
+    }
+    rv += '\n';
+    return rv;
+}
+
+PlannerDaemon * activeDaemon = nullptr;
+
+void stopActiveDaemon(int)
+{
+    if (activeDaemon != nullptr)
+        activeDaemon -> stop();
+}
+
+// serve until SIGINT / SIGTERM; an empty map file name serves the demo floor
+
+void runPlannerDaemon(const std::string & socketPath, const std::string & mapFile)
+{
+    FloorMap floor = FloorMap::demoFloor();
+    if (mapFile.size() > 0 && !floor.load(mapFile))
+    {
+        std::cout << "\nMap file " << mapFile << " could not be loaded.";
+        return;
+    }
+    std::vector<Vertex> U;
+    std::vector<Edge> edgeVector;
+    floor.makeEdgesAndVertices(U, edgeVector);
+    FloorGraph graph(U, edgeVector);
+
+    PlannerDaemon daemon(graph, socketPath);
+    if (!daemon.start((int) std::max(1u, std::thread::hardware_concurrency())))
+    {
+        std::cout << "\nSocket " << socketPath << " could not be opened.";
+        return;
+    }
+    activeDaemon = & daemon;
+    std::signal(SIGINT, stopActiveDaemon);
+    std::signal(SIGTERM, stopActiveDaemon);
+    std::cout << "\nServing " << graph.getVertexCount() << " vertices on " << socketPath << "." << std::flush;
+    daemon.run();
+    activeDaemon = nullptr;
+    std::cout << "\nPlanner daemon has stopped.";
+}
+
+// in-process client: pipelines a batch of queries and reports per-query latency
+
+void runPlannerDaemonDemo()
+{
+    std::cout << "Planner daemon demo will start.";
+    std::vector<Vertex> U;
+    std::vector<Edge> edgeVector;
+    FloorMap::demoFloor().makeEdgesAndVertices(U, edgeVector);
+    FloorGraph graph(U, edgeVector);
+
+    std::string path = "/tmp/coffeeRobot-" + std::to_string(getpid()) + ".sock";
+    PlannerDaemon daemon(graph, path);
+    if (!daemon.start(4))
+    {
+        std::cout << "\nSocket " << path << " could not be opened.";
+        return;
+    }
+    std::thread loop(& PlannerDaemon::run, & daemon);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address;
+    std::memset(& address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, path.c_str());
+    if (connect(fd, (sockaddr *) & address, sizeof(address)) < 0)
+    {
+        std::cout << "\nCould not connect to " << path << ".";
+        daemon.stop();
+        loop.join();
+        return;
+    }
+
+    const int QUERIES = 10000;
+    std::string batch;
+    for (int q = 0; q < QUERIES; q++)
+    {
+        const Vertex & s = graph.getVertex(q % graph.getVertexCount());
+        const Vertex & t = graph.getVertex((q * 7 + 3) % graph.getVertexCount());
+        batch += "ROUTE " + std::to_string(s.getX()) + " " + std::to_string(s.getY()) + " " +
+                 std::to_string(t.getX()) + " " + std::to_string(t.getY()) + "\n";
+    }
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    std::thread sender([fd, &batch]()
+    {
+        size_t sent = 0;
+        while (sent < batch.size())
+        {
+            ssize_t n = write(fd, batch.data() + sent, batch.size() - sent);
+            if (n <= 0)
+                return;
+            sent += (size_t) n;
+        }
+    });
+    std::string replies;
+    int lines = 0;
+    char buffer [65536];
+    while (lines < QUERIES)
+    {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n <= 0)
+            break;
+        for (ssize_t i = 0; i < n; i++)
+            if (buffer[i] == '\n')
+                lines++;
+        if (replies.size() < 4096)
+            replies.append(buffer, (size_t) n);
+    }
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    sender.join();
+    close(fd);
+
+    long long micros = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+    std::cout << "\nFirst reply: " << replies.substr(0, replies.find('\n'));
+    std::cout << "\n" << lines << " pipelined replies in " << micros << " us, ";
+    std::cout << (double) micros / std::max(1, lines) << " us per query.";
+
+    daemon.stop();
+    loop.join();
+}
+
+#endif /* plannerDaemon_h */
@@ -0,0 +1,143 @@
+//  queryOverlay.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Per-query closures of cells and passages on top of a shared FloorGraph.
+
+#ifndef queryOverlay_h
+#define queryOverlay_h
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "floorGraph.h"
+
+// one bit per vertex id and one per directed edge index of the graph it was made
+// for; planners take an overlay alongside a query and skip blocked neighbours in
+// their inner loop, so the graph and anything precomputed on it (landmark
+// tables, distance tables) stay shared and untouched
+// closures only lengthen routes, so lower bounds computed without them still hold
+// the overlay must be rebuilt if the graph is renumbered or its edges change
+
+class QueryOverlay
+{
+    private: // data elements
+        const FloorGraph * graph;
+        std::vector<uint64_t> vertexBits;
+        std::vector<uint64_t> edgeBits;
+        int blockedVertices;
+        int blockedEdges;
+
+    public:
+        QueryOverlay(const FloorGraph &);
+
+    public: // accessors
+        bool isEmpty() const;
+        int getBlockedVertexCount() const;
+        int getBlockedEdgeCount() const;
+        bool isVertexBlocked(int) const;
+        bool isEdgeBlocked(int) const;
+        bool allows(int, int) const;
+
+    public: // mutators
+        bool blockVertex(int);
+        bool blockCell(int, int);
+        bool blockEdge(int, int);
+        void clear();
+};
+
+QueryOverlay::QueryOverlay(const FloorGraph & g)
+{
+    this -> graph = & g;
+    this -> vertexBits.assign((g.getVertexCount() + 63) / 64, 0);
+    this -> edgeBits.assign((g.getEdgeCount() + 63) / 64, 0);
+    this -> blockedVertices = 0;
+    this -> blockedEdges = 0;
+}
+
+bool QueryOverlay::isEmpty() const
+{
+    return this -> blockedVertices == 0 && this -> blockedEdges == 0;
+}
+
+int QueryOverlay::getBlockedVertexCount() const
+{
+    return this -> blockedVertices;
+}
+
+// directed edges, so a closed passage counts twice
+
+int QueryOverlay::getBlockedEdgeCount() const
+{
+    return this -> blockedEdges;
+}
+
+bool QueryOverlay::isVertexBlocked(int v) const
+{
+    return (this -> vertexBits[v >> 6] >> (v & 63)) & 1;
+}
+
+bool QueryOverlay::isEdgeBlocked(int e) const
+{
+    return (this -> edgeBits[e >> 6] >> (e & 63)) & 1;
+}
+
+// may a search follow edge e into vertex v
+
+bool QueryOverlay::allows(int e, int v) const
+{
+    return !isVertexBlocked(v) && !isEdgeBlocked(e);
+}
+
+// returns false for an id outside the graph
+
+bool QueryOverlay::blockVertex(int v)
+{
+    if (v < 0 || v >= this -> graph -> getVertexCount())
+        return false;
+    if (!isVertexBlocked(v))
+    {
+        this -> vertexBits[v >> 6] |= 1ULL << (v & 63);
+        this -> blockedVertices++;
+    }
+    return true;
+}
+
+bool QueryOverlay::blockCell(int x, int y)
+{
+    return blockVertex(this -> graph -> findId(x, y));
+}
+
+// closes u -- v in both directions; returns false if there is no such edge
+
+bool QueryOverlay::blockEdge(int u, int v)
+{
+    int vCount = this -> graph -> getVertexCount();
+    if (u < 0 || u >= vCount || v < 0 || v >= vCount)
+        return false;
+    bool rv = false;
+    for (int k = 0; k < 2; k++)
+    {
+        int from = (k == 0) ? u : v;
+        int to = (k == 0) ? v : u;
+        for (int e = this -> graph -> getFirstEdge(from); e < this -> graph -> getLastEdge(from); e++)
+            if (this -> graph -> getTarget(e) == to)
+            {
+                if (!isEdgeBlocked(e))
+                {
+                    this -> edgeBits[e >> 6] |= 1ULL << (e & 63);
+                    this -> blockedEdges++;
+                }
+                rv = true;
+            }
+    }
+    return rv;
+}
+
+void QueryOverlay::clear()
+{
+    std::fill(this -> vertexBits.begin(), this -> vertexBits.end(), 0);
+    std::fill(this -> edgeBits.begin(), this -> edgeBits.end(), 0);
+    this -> blockedVertices = 0;
+    this -> blockedEdges = 0;
+}
+
+#endif /* queryOverlay_h */
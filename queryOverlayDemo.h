@@ -0,0 +1,103 @@
+//  queryOverlayDemo.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Demo of per-query closures against shared planners and landmark tables.
+
+#ifndef queryOverlayDemo_h
+#define queryOverlayDemo_h
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include "floorGenerator.h"
+#include "floorGraph.h"
+#include "floorMap.h"
+#include "heuristicSearch.h"
+#include "landmarks.h"
+#include "queryOverlay.h"
+#include "weightedSearch.h"
+
+// closures per query against one shared graph and landmark table, checked
+// against a graph rebuilt with the closed cells walled off
+
+void runQueryOverlay()
+{
+    std::cout << "Query overlay testing will start.";
+
+    // demo floor with the top corridor closed for cleaning
+
+    FloorMap floor = FloorMap::demoFloor();
+    std::vector<Vertex> U;
+    std::vector<Edge> edgeVector;
+    floor.makeEdgesAndVertices(U, edgeVector);
+    FloorGraph graph(U, edgeVector);
+    DijkstraPlanner planner(graph);
+    QueryOverlay cleaning(graph);
+    cleaning.blockCell(6, 2);
+    std::vector<int> route;
+    int length = planner.coffeeRoute(graph.findId(3, 2), graph.findId(3, 4), route);
+    std::cout << "\nOpen floor, length " << length << ":";
+    graph.printRoute(route);
+    length = planner.coffeeRoute(graph.findId(3, 2), graph.findId(3, 4), route, cleaning);
+    std::cout << "\nWith (6, 2) closed, length " << length << ":";
+    graph.printRoute(route);
+
+    // a larger floor: every query closes its own random cells
+
+    FloorMap big;
+    FloorGenerator::generate("rooms", 400, 400, 6, 46, big);
+    std::vector<Vertex> bigU;
+    std::vector<Edge> bigEdges;
+    big.makeEdgesAndVertices(bigU, bigEdges);
+    FloorGraph bigGraph(bigU, bigEdges);
+    uint64_t print = bigGraph.fingerprint();
+    LandmarkTable table(bigGraph);
+    table.select(8);
+    LandmarkHeuristic alt(table);
+    AStarPlanner astar(bigGraph, alt);
+    DijkstraPlanner dijkstra(bigGraph);
+    QueryOverlay overlay(bigGraph);
+
+    const int QUERIES = 10;
+    FloorGenerator random(46);
+    int mismatches = 0;
+    long long overlayMicros = 0;
+    long long rebuildMicros = 0;
+    for (int q = 0; q < QUERIES; q++)
+    {
+        int start = random.below(bigGraph.getVertexCount());
+        int goal = random.below(bigGraph.getVertexCount());
+        FloorMap closed = big;
+        overlay.clear();
+        for (int k = 0; k < 200; k++)
+        {
+            int v = random.below(bigGraph.getVertexCount());
+            if (v == start || v == goal || bigGraph.getVertex(v).getC())
+                continue;
+            overlay.blockVertex(v);
+            closed.setCell(bigGraph.getVertex(v).getX(), bigGraph.getVertex(v).getY(), '#');
+        }
+
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        int withOverlay = dijkstra.coffeeRoute(start, goal, route, overlay);
+        int withTable = astar.coffeeRoute(start, goal, route, overlay);
+        std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+        std::vector<Vertex> closedU;
+        std::vector<Edge> closedEdges;
+        closed.makeEdgesAndVertices(closedU, closedEdges);
+        FloorGraph rebuilt(closedU, closedEdges);
+        DijkstraPlanner fresh(rebuilt);
+        int expected = fresh.coffeeRoute(rebuilt.findId(bigGraph.getVertex(start)), rebuilt.findId(bigGraph.getVertex(goal)), route);
+        std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+        overlayMicros += std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+        rebuildMicros += std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+        if (withOverlay != expected || withTable != expected)
+            mismatches++;
+    }
+    std::cout << "\n" << bigGraph.getVertexCount() << " vertices, " << QUERIES << " queries with their own closures.";
+    std::cout << "\nOverlay (Dijkstra and landmark A*): " << overlayMicros / 1000 << " ms.";
+    std::cout << "\nRebuilt graph per query: " << rebuildMicros / 1000 << " ms, " << mismatches << " mismatches.";
+    std::cout << "\nShared graph " << ((bigGraph.fingerprint() == print) ? "unchanged." : "changed.");
+}
+
+#endif /* queryOverlayDemo_h */
@@ -0,0 +1,413 @@
+//  routeBatch.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Binary result files for batch planning runs, written a buffer at a time.
+
+#ifndef routeBatch_h
+#define routeBatch_h
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "floorGenerator.h"
+#include "floorGraph.h"
+#include "moveString.h"
+#include "oneToMany.h"
+
+// batch file (native byte order)
+//   char[4]   "CRB1"
+//   uint64    FloorGraph::fingerprint of the map the routes were planned on
+//   records to the end of the file, each
+//     uint32  record bytes after this field
+//     int32   start id, goal id, route length (-1 if there is none), start x, start y
+//     uint32  move count
+//     uint8[] MoveString runs (record bytes - 24 of them)
+// records are gathered in a preallocated buffer and written with one write()
+// when it is full; the file is written beside its final name and renamed over
+// it on close, so readers never see half a batch
+
+struct RouteRecord
+{
+    int start;
+    int goal;
+    int length;
+    MoveString moves;
+};
+
+class RouteBatchWriter
+{
+    private: // data elements
+        std::string fileName;
+        int fd;
+        std::vector<char> buffer;
+        size_t used;
+        long long records;
+        long long bytesWritten;
+        bool failed;
+
+    public:
+        static constexpr size_t RECORD_HEADER = 28;
+
+    public:
+        RouteBatchWriter(size_t);
+        RouteBatchWriter(const RouteBatchWriter &) = delete;
+        RouteBatchWriter & operator=(const RouteBatchWriter &) = delete;
+        ~RouteBatchWriter();
+
+    public: // accessors
+        long long getRecordCount() const;
+        long long getBytesWritten() const;
+
+    public: // output
+        bool open(const std::string &, uint64_t);
+        bool add(int, int, int, const MoveString &);
+        bool add(const FloorGraph &, int, int, int, const std::vector<int> &);
+        bool flush();
+        bool close();
+
+    private:
+        void put(const void *, size_t);
+};
+
+RouteBatchWriter::RouteBatchWriter(size_t bufferBytes)
+{
+    this -> fd = -1;
+    this -> buffer.resize(std::max((size_t) 4096, bufferBytes));
+    this -> used = 0;
+    this -> records = 0;
+    this -> bytesWritten = 0;
+    this -> failed = false;
+}
+
+// an open file that was never closed is dropped, not renamed into place
+
+RouteBatchWriter::~RouteBatchWriter()
+{
+    if (this -> fd >= 0)
+    {
+        ::close(this -> fd);
+        std::remove((this -> fileName + ".tmp").c_str());
+    }
+}
+
+long long RouteBatchWriter::getRecordCount() const
+{
+    return this -> records;
+}
+
+long long RouteBatchWriter::getBytesWritten() const
+{
+    return this -> bytesWritten;
+}
+
+void RouteBatchWriter::put(const void * data, size_t length)
+{
+    std::memcpy(this -> buffer.data() + this -> used, data, length);
+    this -> used += length;
+}
+
+bool RouteBatchWriter::open(const std::string & name, uint64_t fingerprint)
+{
+    if (this -> fd >= 0)
+        return false;
+    this -> fileName = name;
+    this -> fd = ::open((name + ".tmp").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (this -> fd < 0)
+        return false;
+    this -> used = 0;
+    this -> records = 0;
+    this -> bytesWritten = 0;
+    this -> failed = false;
+    put("CRB1", 4);
+    put(& fingerprint, sizeof(fingerprint));
+    return true;
+}
+
+// a record larger than the whole buffer is written on its own
+
+bool RouteBatchWriter::add(int start, int goal, int length, const MoveString & moves)
+{
+    if (this -> fd < 0 || this -> failed)
+        return false;
+    const std::vector<uint8_t> & runs = moves.getRuns();
+    uint32_t recordBytes = (uint32_t) (RECORD_HEADER - sizeof(uint32_t) + runs.size());
+    size_t total = sizeof(uint32_t) + recordBytes;
+    if (this -> used + total > this -> buffer.size() && !flush())
+        return false;
+    if (total > this -> buffer.size())
+        this -> buffer.resize(total);
+
+    int32_t fields [5] = { start, goal, length, moves.getStartX(), moves.getStartY() };
+    uint32_t moveCount = (uint32_t) moves.getMoveCount();
+    put(& recordBytes, sizeof(recordBytes));
+    put(fields, sizeof(fields));
+    put(& moveCount, sizeof(moveCount));
+    put(runs.data(), runs.size());
+    this -> records++;
+    return true;
+}
+
+bool RouteBatchWriter::add(const FloorGraph & g, int start, int goal, int length, const std::vector<int> & route)
+{
+    MoveString moves;
+    if (length >= 0 && !moves.encode(g, route))
+        return false;
+    return add(start, goal, length, moves);
+}
+
+bool RouteBatchWriter::flush()
+{
+    if (this -> fd < 0 || this -> failed)
+        return false;
+    size_t done = 0;
+    while (done < this -> used)
+    {
+        ssize_t rc = ::write(this -> fd, this -> buffer.data() + done, this -> used - done);
+        if (rc < 0 && errno == EINTR)
+            continue;
+        if (rc <= 0)
+        {
+            this -> failed = true;
+            return false;
+        }
+        done += (size_t) rc;
+    }
+    this -> bytesWritten += (long long) this -> used;
+    this -> used = 0;
+    return true;
+}
+
+// writes what is left, then moves the file to its final name
+// returns false (and removes the partial file) if any write failed
+
+bool RouteBatchWriter::close()
+{
+    if (this -> fd < 0)
+        return false;
+    bool ok = flush();
+    ok = (fsync(this -> fd) == 0) && ok;
+    ok = (::close(this -> fd) == 0) && ok;
+    this -> fd = -1;
+    std::string temporary = this -> fileName + ".tmp";
+    if (!ok || std::rename(temporary.c_str(), this -> fileName.c_str()) != 0)
+    {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+// the file is memory-mapped and records are decoded in place, one per next() call
+
+class RouteBatchReader
+{
+    private: // data elements
+        const char * data;
+        size_t length;
+        size_t offset;
+        uint64_t fingerprint;
+
+    public:
+        RouteBatchReader();
+        RouteBatchReader(const RouteBatchReader &) = delete;
+        RouteBatchReader & operator=(const RouteBatchReader &) = delete;
+        ~RouteBatchReader();
+
+    public: // accessors
+        uint64_t getFingerprint() const;
+
+    public: // input
+        bool open(const std::string &);
+        bool next(RouteRecord &);
+        void close();
+};
+
+RouteBatchReader::RouteBatchReader()
+{
+    this -> data = nullptr;
+    this -> length = 0;
+    this -> offset = 0;
+    this -> fingerprint = 0;
+}
+
+RouteBatchReader::~RouteBatchReader()
+{
+    close();
+}
+
+uint64_t RouteBatchReader::getFingerprint() const
+{
+    return this -> fingerprint;
+}
+
+// returns false if the file is missing or is not a batch file
+
+bool RouteBatchReader::open(const std::string & fileName)
+{
+    close();
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, & info) != 0 || info.st_size < 12)
+    {
+        ::close(fd);
+        return false;
+    }
+    void * mapping = mmap(nullptr, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+    this -> data = (const char *) mapping;
+    this -> length = (size_t) info.st_size;
+    if (std::memcmp(this -> data, "CRB1", 4) != 0)
+    {
+        close();
+        return false;
+    }
+    std::memcpy(& this -> fingerprint, this -> data + 4, sizeof(this -> fingerprint));
+    madvise(mapping, this -> length, MADV_SEQUENTIAL);
+    this -> offset = 12;
+    return true;
+}
+
+// false at the end of the file, or at a truncated or damaged record
+
+bool RouteBatchReader::next(RouteRecord & record)
+{
+    uint32_t recordBytes = 0;
+    if (this -> data == nullptr || this -> offset + RouteBatchWriter::RECORD_HEADER > this -> length)
+        return false;
+    std::memcpy(& recordBytes, this -> data + this -> offset, sizeof(recordBytes));
+    size_t end = this -> offset + sizeof(recordBytes) + recordBytes;
+    if (recordBytes < RouteBatchWriter::RECORD_HEADER - sizeof(recordBytes) || end > this -> length)
+        return false;
+
+    int32_t fields [5];
+    uint32_t moveCount = 0;
+    const char * p = this -> data + this -> offset + sizeof(recordBytes);
+    std::memcpy(fields, p, sizeof(fields));
+    std::memcpy(& moveCount, p + sizeof(fields), sizeof(moveCount));
+    const uint8_t * runs = (const uint8_t *) (p + sizeof(fields) + sizeof(moveCount));
+    size_t runCount = end - (this -> offset + RouteBatchWriter::RECORD_HEADER);
+
+    record.start = fields[0];
+    record.goal = fields[1];
+    record.length = fields[2];
+    record.moves.reset(fields[3], fields[4]);
+    for (size_t r = 0; r < runCount; r++)
+        record.moves.addRun(runs[r] >> 6, (runs[r] & 63) + 1);
+    this -> offset = end;
+    return (uint32_t) record.moves.getMoveCount() == moveCount;
+}
+
+void RouteBatchReader::close()
+{
+    if (this -> data != nullptr)
+        munmap((void *) this -> data, this -> length);
+    this -> data = nullptr;
+    this -> length = 0;
+    this -> offset = 0;
+}
+
+// every desk to every other desk by way of a coffee station, written once as
+// printRoute-style text and once as a batch file, then read back and checked
+
+void runRouteBatch()
+{
+    std::cout << "Route batch testing will start.";
+
+    FloorMap floor;
+    FloorGenerator::generate("rooms", 400, 400, 4, 43, floor);
+    std::vector<Vertex> U;
+    std::vector<Edge> edgeVector;
+    floor.makeEdgesAndVertices(U, edgeVector);
+    FloorGraph graph(U, edgeVector);
+
+    const int DESKS = 60;
+    FloorGenerator desks(11);
+    std::vector<int> targets;
+    for (int i = 0; i < DESKS; i++)
+        targets.push_back(desks.below(graph.getVertexCount()));
+
+    std::string textName = "/tmp/coffeeRobot-" + std::to_string(getpid()) + ".txt";
+    std::string batchName = "/tmp/coffeeRobot-" + std::to_string(getpid()) + ".crb";
+    OneToManyPlanner planner(graph);
+    std::vector<int> lengths;
+    std::vector<int> route;
+    long long textNanos = 0;
+    long long batchNanos = 0;
+
+    std::ofstream text(textName.c_str());
+    RouteBatchWriter batch(1 << 20);
+    batch.open(batchName, graph.fingerprint());
+    for (int i = 0; i < DESKS; i++)
+    {
+        planner.coffeeDistances(targets[i], targets, lengths);
+        for (int j = 0; j < DESKS; j++)
+        {
+            planner.coffeeRoute(targets[j], route);
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            text << "\n{ ";
+            for (size_t k = 0; k < route.size(); k++)
+            {
+                const Vertex & v = graph.getVertex(route[k]);
+                text << ((k > 0) ? ", " : "") << "[ (" << v.getX() << ", " << v.getY() << "), " << (v.getC() ? 'c' : 'n') << " ]";
+            }
+            text << " }";
+            std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+            batch.add(graph, targets[i], targets[j], lengths[j], route);
+            std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+            textNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+            batchNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count();
+        }
+    }
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    text.close();
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    bool written = batch.close();
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+    textNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+    batchNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count();
+
+    struct stat info;
+    long long textBytes = (stat(textName.c_str(), & info) == 0) ? (long long) info.st_size : -1;
+
+    // read back: every record must walk from its start to its goal in length moves
+
+    RouteBatchReader reader;
+    RouteRecord record;
+    long long records = 0;
+    int bad = 0;
+    t0 = std::chrono::steady_clock::now();
+    bool opened = reader.open(batchName) && reader.getFingerprint() == graph.fingerprint();
+    while (opened && reader.next(record))
+    {
+        records++;
+        if (record.length < 0)
+            continue;
+        bool ok = record.moves.decode(graph, route) && route.size() > 0;
+        if (!ok || route.front() != record.start || route.back() != record.goal || record.moves.getMoveCount() != record.length)
+            bad++;
+    }
+    t1 = std::chrono::steady_clock::now();
+
+    std::cout << "\n" << graph.getVertexCount() << " vertices, " << DESKS * DESKS << " desk pairs.";
+    std::cout << "\nText: " << textBytes << " bytes in " << textNanos / 1000 << " us.";
+    std::cout << "\nBatch: " << batch.getBytesWritten() << " bytes in " << batchNanos / 1000 << " us";
+    std::cout << (written ? "." : " (write failed).");
+    std::cout << "\nRead back " << records << " records in ";
+    std::cout << std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() << " us, " << bad << " bad.";
+    std::remove(textName.c_str());
+    std::remove(batchName.c_str());
+}
+
+#endif /* routeBatch_h */
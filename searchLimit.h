@@ -0,0 +1,213 @@
+//  searchLimit.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Deadlines and cooperative cancellation for planner calls.
+
+#ifndef searchLimit_h
+#define searchLimit_h
+#include <atomic>
+#include <chrono>
+
+// how a limited search ended; a search cut short still reports the best route
+// it had (anytime planners) or -1 with its step count
+
+enum class SearchStatus
+{
+    FOUND,
+    NOT_FOUND,
+    EXPIRED,
+    CANCELLED
+};
+
+struct SearchResult
+{
+    SearchStatus status;
+    int length;                     // route length, or the best so far when cut short, or -1
+    long long steps;                // expansions (levels for WorkBook) before the search ended
+    long long elapsedMicroseconds;  // since the limit was made
+};
+
+// set from any thread (or a signal handler) to stop every search holding it
+
+class CancelToken
+{
+    private: // data elements
+        std::atomic<bool> cancelled;
+
+    public:
+        CancelToken();
+        CancelToken(const CancelToken &) = delete;
+        CancelToken & operator=(const CancelToken &) = delete;
+
+    public:
+        bool isCancelled() const;
+        void cancel();
+        void reset();
+};
+
+CancelToken::CancelToken()
+{
+    this -> cancelled = false;
+}
+
+bool CancelToken::isCancelled() const
+{
+    return this -> cancelled.load(std::memory_order_relaxed);
+}
+
+void CancelToken::cancel()
+{
+    this -> cancelled.store(true, std::memory_order_relaxed);
+}
+
+void CancelToken::reset()
+{
+    this -> cancelled.store(false, std::memory_order_relaxed);
+}
+
+// one per request: a deadline, a token, both or neither
+// searches call shouldStop() once per expansion, which reads the token and the
+// clock on the first call and then every STRIDE calls, and checkNow() once per level; once either has
+// said stop, both keep saying so and getStatus() tells which limit was hit
+
+class SearchLimit
+{
+    private: // data elements
+        std::chrono::steady_clock::time_point started;
+        std::chrono::steady_clock::time_point deadline;
+        bool timed;
+        const CancelToken * token;
+        long long steps;
+        int countdown;
+        SearchStatus stopped;
+
+    public:
+        static constexpr int STRIDE = 256;
+
+    public:
+        SearchLimit(); // no limit, steps and time are still counted
+        SearchLimit(std::chrono::steady_clock::time_point);
+        SearchLimit(const CancelToken &);
+        SearchLimit(std::chrono::steady_clock::time_point, const CancelToken &);
+
+    public: // accessors
+        bool isStopped() const;
+        SearchStatus getStatus() const;
+        long long getSteps() const;
+        long long getElapsedMicroseconds() const;
+        SearchResult finish(int) const;
+
+    public: // checks
+        bool shouldStop();
+        bool checkNow();
+
+    private:
+        bool poll();
+};
+
+SearchLimit::SearchLimit()
+{
+    this -> started = std::chrono::steady_clock::now();
+    this -> timed = false;
+    this -> token = nullptr;
+    this -> steps = 0;
+    this -> countdown = 1;
+    this -> stopped = SearchStatus::FOUND;
+}
+
+SearchLimit::SearchLimit(std::chrono::steady_clock::time_point when)
+{
+    this -> started = std::chrono::steady_clock::now();
+    this -> deadline = when;
+    this -> timed = true;
+    this -> token = nullptr;
+    this -> steps = 0;
+    this -> countdown = 1;
+    this -> stopped = SearchStatus::FOUND;
+}
+
+SearchLimit::SearchLimit(const CancelToken & cancel)
+{
+    this -> started = std::chrono::steady_clock::now();
+    this -> timed = false;
+    this -> token = & cancel;
+    this -> steps = 0;
+    this -> countdown = 1;
+    this -> stopped = SearchStatus::FOUND;
+}
+
+SearchLimit::SearchLimit(std::chrono::steady_clock::time_point when, const CancelToken & cancel)
+{
+    this -> started = std::chrono::steady_clock::now();
+    this -> deadline = when;
+    this -> timed = true;
+    this -> token = & cancel;
+    this -> steps = 0;
+    this -> countdown = 1;
+    this -> stopped = SearchStatus::FOUND;
+}
+
+bool SearchLimit::isStopped() const
+{
+    return this -> stopped != SearchStatus::FOUND;
+}
+
+// EXPIRED or CANCELLED once stopped, FOUND before
+
+SearchStatus SearchLimit::getStatus() const
+{
+    return this -> stopped;
+}
+
+long long SearchLimit::getSteps() const
+{
+    return this -> steps;
+}
+
+long long SearchLimit::getElapsedMicroseconds() const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - this -> started).count();
+}
+
+// the result of a search that returned length (-1 for none) under this limit
+
+SearchResult SearchLimit::finish(int length) const
+{
+    SearchResult rv;
+    if (isStopped())
+        rv.status = this -> stopped;
+    else
+        rv.status = (length >= 0) ? SearchStatus::FOUND : SearchStatus::NOT_FOUND;
+    rv.length = length;
+    rv.steps = this -> steps;
+    rv.elapsedMicroseconds = getElapsedMicroseconds();
+    return rv;
+}
+
+bool SearchLimit::shouldStop()
+{
+    this -> steps++;
+    if (--(this -> countdown) > 0)
+        return isStopped();
+    this -> countdown = STRIDE;
+    return poll();
+}
+
+bool SearchLimit::checkNow()
+{
+    this -> steps++;
+    return poll();
+}
+
+bool SearchLimit::poll()
+{
+    if (isStopped())
+        return true;
+    if (this -> token != nullptr && this -> token -> isCancelled())
+        this -> stopped = SearchStatus::CANCELLED;
+    else if (this -> timed && std::chrono::steady_clock::now() >= this -> deadline)
+        this -> stopped = SearchStatus::EXPIRED;
+    return isStopped();
+}
+
+#endif /* searchLimit_h */
@@ -0,0 +1,93 @@
+//  searchLimitDemo.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Demo of deadlines and cancellation across the planners and the daemon.
+
+#ifndef searchLimitDemo_h
+#define searchLimitDemo_h
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "anytimePlanner.h"
+#include "floorGenerator.h"
+#include "floorGraph.h"
+#include "floorMap.h"
+#include "heuristicSearch.h"
+#include "plannerDaemon.h"
+#include "searchLimit.h"
+#include "weightedSearch.h"
+
+// one far query under shrinking budgets: exact planners give up with their step
+// counts, the anytime planner returns its best route so far; then a token
+// cancelled from another thread, and the daemon's answer to a late request
+
+void runSearchLimit()
+{
+    std::cout << "Search limit testing will start.";
+
+    FloorMap floor;
+    FloorGenerator::generate("rooms", 1200, 1200, 6, 45, floor);
+    std::vector<Vertex> U;
+    std::vector<Edge> edgeVector;
+    floor.makeEdgesAndVertices(U, edgeVector);
+    FloorGraph graph(U, edgeVector);
+    int start = 0;
+    int goal = graph.getVertexCount() - 1;
+
+    const char * names [4] = { "found", "not found", "expired", "cancelled" };
+    auto print = [&names](const std::string & planner, long long budget, const SearchResult & result)
+    {
+        std::cout << "\n" << planner;
+        if (budget > 0)
+            std::cout << ", budget " << budget << " us";
+        std::cout << ": " << names[(int) result.status];
+        std::cout << ", length " << result.length << ", " << result.steps << " steps, ";
+        std::cout << result.elapsedMicroseconds << " us.";
+    };
+
+    DijkstraPlanner dijkstra(graph);
+    ManhattanHeuristic manhattan(graph);
+    AStarPlanner astar(graph, manhattan);
+    AnytimePlanner anytime(graph, manhattan);
+    std::vector<int> route;
+    long long budgets [3] = { 5000, 20000, 2000000 };
+    for (int b = 0; b < 3; b++)
+    {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        SearchLimit first(now + std::chrono::microseconds(budgets[b]));
+        print("Dijkstra", budgets[b], dijkstra.coffeeRoute(start, goal, route, first));
+        now = std::chrono::steady_clock::now();
+        SearchLimit second(now + std::chrono::microseconds(budgets[b]));
+        print("A*", budgets[b], astar.coffeeRoute(start, goal, route, second));
+        now = std::chrono::steady_clock::now();
+        SearchLimit third(now + std::chrono::microseconds(budgets[b]));
+        print("Anytime", budgets[b], anytime.coffeeRoute(start, goal, route, third));
+    }
+
+    // no deadline; another thread pulls the plug after 5 ms
+
+    CancelToken token;
+    SearchLimit cancellable(token);
+    std::thread canceller([&token]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        token.cancel();
+    });
+    SearchResult cancelled = dijkstra.coffeeRoute(start, goal, route, cancellable);
+    canceller.join();
+    print("Dijkstra, no deadline, cancelled after 5 ms", 0, cancelled);
+
+    // the daemon's reply once a request has waited out its budget
+
+    const Vertex & s = graph.getVertex(start);
+    const Vertex & t = graph.getVertex(goal);
+    std::string request = "ROUTE " + std::to_string(s.getX()) + " " + std::to_string(s.getY()) + " " +
+                          std::to_string(t.getX()) + " " + std::to_string(t.getY());
+    SearchLimit late(std::chrono::steady_clock::now());
+    std::string reply = PlannerDaemon::answer(graph, dijkstra, request, late);
+    std::cout << "\nDaemon reply to a late request: " << reply.substr(0, reply.size() - 1) << ".";
+}
+
+#endif /* searchLimitDemo_h */
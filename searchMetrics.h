@@ -0,0 +1,266 @@
+//  searchMetrics.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Per-stage search metrics with optional hardware counters, exported as JSON.
+
+#ifndef searchMetrics_h
+#define searchMetrics_h
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "graphSolution.h"
+
+// cycles, instructions and cache misses of this thread, user space only, read as
+// one group; perf_event_open is often refused (containers, perf_event_paranoid),
+// in which case isAvailable() is false and the JSON carries nulls
+
+class PerfCounters
+{
+    private: // data elements
+        int fds [3];
+        bool available;
+
+    public:
+        static constexpr int COUNT = 3;
+
+    public:
+        PerfCounters(bool);
+        PerfCounters(const PerfCounters &) = delete;
+        PerfCounters & operator=(const PerfCounters &) = delete;
+        ~PerfCounters();
+
+    public:
+        bool isAvailable() const;
+        bool read(long long [3]) const;
+};
+
+PerfCounters::PerfCounters(bool enabled)
+{
+    const uint64_t configs [COUNT] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES };
+    this -> available = enabled;
+    for (int i = 0; i < COUNT; i++)
+        this -> fds[i] = -1;
+    for (int i = 0; i < COUNT && this -> available; i++)
+    {
+        struct perf_event_attr attr;
+        std::memset(& attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = configs[i];
+        attr.disabled = (i == 0);
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        this -> fds[i] = (int) syscall(__NR_perf_event_open, & attr, 0, -1, (i == 0) ? -1 : this -> fds[0], 0);
+        this -> available = (this -> fds[i] >= 0);
+    }
+    if (this -> available)
+        this -> available = ioctl(this -> fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) == 0;
+}
+
+PerfCounters::~PerfCounters()
+{
+    for (int i = COUNT - 1; i >= 0; i--)
+        if (this -> fds[i] >= 0)
+            close(this -> fds[i]);
+}
+
+bool PerfCounters::isAvailable() const
+{
+    return this -> available;
+}
+
+// running totals since construction
+
+bool PerfCounters::read(long long values [3]) const
+{
+    uint64_t buffer [1 + COUNT];
+    if (!this -> available || ::read(this -> fds[0], buffer, sizeof(buffer)) != (ssize_t) sizeof(buffer) || buffer[0] != COUNT)
+        return false;
+    for (int i = 0; i < COUNT; i++)
+        values[i] = (long long) buffer[1 + i];
+    return true;
+}
+
+// one timed stage of a query: a calibrate, addBook or goal test call
+
+struct StageMetrics
+{
+    std::string stage;
+    int level;
+    long long wallNanos;
+    SearchCounters counters;
+    bool hasHardware;
+    long long hardware [PerfCounters::COUNT];
+};
+
+class SearchMetrics
+{
+    private: // data elements
+        PerfCounters perf;
+        std::vector<StageMetrics> stages;
+        Vertex start;
+        Vertex goal;
+        int delay;
+        bool solved;
+        int solutionSize;
+
+    public:
+        SearchMetrics(bool);
+
+    public: // recording
+        template <typename Stage>
+        void measure(const char *, int, Stage);
+        void addBooks(WorkBook &, int);
+
+    public: // export
+        void writeJson(std::ostream &) const;
+        std::string toJson() const;
+};
+
+SearchMetrics::SearchMetrics(bool hardwareCounters) : perf(hardwareCounters)
+{
+    this -> delay = 0;
+    this -> solved = false;
+    this -> solutionSize = 0;
+}
+
+// runs stage() with the path counters pointed at a fresh record
+// (nested measurements leave the outer record untouched)
+
+template <typename Stage>
+void SearchMetrics::measure(const char * name, int level, Stage stage)
+{
+    StageMetrics record;
+    record.stage = name;
+    record.level = level;
+    std::memset(& record.counters, 0, sizeof(record.counters));
+    long long before [PerfCounters::COUNT] = { 0, 0, 0 };
+    long long after [PerfCounters::COUNT] = { 0, 0, 0 };
+
+    SearchCounters * previous = activeCounters;
+    activeCounters = & record.counters;
+    bool hardware = this -> perf.read(before);
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    stage();
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    hardware = this -> perf.read(after) && hardware;
+    activeCounters = previous;
+
+    record.wallNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+    record.hasHardware = hardware;
+    for (int i = 0; i < PerfCounters::COUNT; i++)
+        record.hardware[i] = after[i] - before[i];
+    this -> stages.push_back(record);
+}
+
+// WorkBook::addBooks with every calibrate, addBook and goal test measured
+
+void SearchMetrics::addBooks(WorkBook & wb, int n)
+{
+    this -> start = wb.start;
+    this -> goal = wb.goal;
+    this -> delay = n;
+    this -> solved = false;
+    this -> solutionSize = 0;
+
+    int m = wb.levelsLeft();
+    while (m > 0 && !this -> solved && (wb.books + wb.booksCount - 1) -> getBookSize() > 0)
+    {
+        int level = wb.booksCount + 1;
+        measure("calibrate", level, [&wb, n]() { wb.calibrate(n); });
+        measure("addBook", level, [&wb]() { wb.addBook(); });
+        bool found = false;
+        measure("goalFound", level, [&wb, &found]() { found = wb.goalFound(); });
+        this -> solved = found;
+        m--;
+    }
+    if (this -> solved)
+        this -> solutionSize = ((wb.books + wb.booksCount - 1) -> getBookPtr() + wb.solution) -> getPathSize();
+}
+
+void SearchMetrics::writeJson(std::ostream & out) const
+{
+    const char * hardwareNames [PerfCounters::COUNT] = { "cycles", "instructions", "cacheMisses" };
+    SearchCounters total;
+    std::memset(& total, 0, sizeof(total));
+    long long wallTotal = 0;
+
+    out << "{\"query\":{\"start\":[" << this -> start.getX() << "," << this -> start.getY() << "]";
+    out << ",\"goal\":[" << this -> goal.getX() << "," << this -> goal.getY() << "]";
+    out << ",\"delay\":" << this -> delay << ",\"solved\":" << (this -> solved ? "true" : "false");
+    out << ",\"solutionSize\":" << this -> solutionSize << "}";
+    out << ",\"hardwareCounters\":" << (this -> perf.isAvailable() ? "true" : "false");
+    out << ",\"stages\":[";
+    for (size_t i = 0; i < this -> stages.size(); i++)
+    {
+        const StageMetrics & s = this -> stages[i];
+        out << ((i > 0) ? "," : "") << "{\"stage\":\"" << s.stage << "\",\"level\":" << s.level;
+        out << ",\"wallNanos\":" << s.wallNanos;
+        out << ",\"pathsGenerated\":" << s.counters.pathsGenerated;
+        out << ",\"duplicatesRejected\":" << s.counters.duplicatesRejected;
+        out << ",\"verticesExpanded\":" << s.counters.verticesExpanded;
+        out << ",\"allocations\":" << s.counters.allocations;
+        out << ",\"bytes\":" << s.counters.bytes;
+        for (int h = 0; h < PerfCounters::COUNT; h++)
+        {
+            out << ",\"" << hardwareNames[h] << "\":";
+            if (s.hasHardware)
+                out << s.hardware[h];
+            else
+                out << "null";
+        }
+        out << "}";
+        total.pathsGenerated += s.counters.pathsGenerated;
+        total.duplicatesRejected += s.counters.duplicatesRejected;
+        total.verticesExpanded += s.counters.verticesExpanded;
+        total.allocations += s.counters.allocations;
+        total.bytes += s.counters.bytes;
+        wallTotal += s.wallNanos;
+    }
+    out << "],\"totals\":{\"wallNanos\":" << wallTotal;
+    out << ",\"pathsGenerated\":" << total.pathsGenerated;
+    out << ",\"duplicatesRejected\":" << total.duplicatesRejected;
+    out << ",\"verticesExpanded\":" << total.verticesExpanded;
+    out << ",\"allocations\":" << total.allocations;
+    out << ",\"bytes\":" << total.bytes << "}}";
+}
+
+std::string SearchMetrics::toJson() const
+{
+    std::ostringstream out;
+    writeJson(out);
+    return out.str();
+}
+
+// the default WorkBook query with its console output silenced, reported as JSON
+
+void runSearchMetrics()
+{
+    std::ostringstream discarded;
+    std::streambuf * console = std::cout.rdbuf(discarded.rdbuf());
+    std::string json;
+    {
+        std::vector<Vertex> U;
+        std::vector<Vertex> n;
+        std::vector<Vertex> ex;
+        std::vector<Vertex> fr;
+        std::vector<Edge> edgeVector;
+        WorkBook wb ( 2, U, n, ex, fr, edgeVector );
+        SearchMetrics metrics(true);
+        metrics.addBooks(wb, 2);
+        json = metrics.toJson();
+    }
+    std::cout.rdbuf(console);
+    std::cout << json;
+}
+
+#endif /* searchMetrics_h */
@@ -0,0 +1,357 @@
+//  sharedGraph.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  One immutable graph shared by many threads, with pooled per-query search contexts.
+
+#ifndef sharedGraph_h
+#define sharedGraph_h
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "floorGenerator.h"
+#include "floorGraph.h"
+#include "floorMap.h"
+#include "queryOverlay.h"
+#include "searchLimit.h"
+#include "weightedSearch.h"
+
+// the graph is built once and only ever reached through a pointer to const, so
+// every thread may read it without locks; the last owner frees it
+
+typedef std::shared_ptr<const FloorGraph> SharedGraph;
+
+SharedGraph makeSharedGraph(const FloorMap & floor)
+{
+    std::vector<Vertex> U;
+    std::vector<Edge> edgeVector;
+    floor.makeEdgesAndVertices(U, edgeVector);
+    return std::make_shared<const FloorGraph>(U, edgeVector);
+}
+
+// scratch space for one search at a time
+// a state's dist and parent are valid only when seen[state] equals the current
+// generation, so starting a search is one increment instead of clearing 2V entries
+
+class SearchContext
+{
+    private: // data elements
+        std::vector<uint32_t> seen;
+        std::vector<int> dist;
+        std::vector<int> parent;
+        BucketQueue queue;
+        uint32_t generation;
+
+    public:
+        SearchContext();
+
+    public: // accessors
+        bool isSeen(int) const;
+        int getDist(int) const;
+        int getParent(int) const;
+
+    public: // mutators
+        void begin(int, int);
+        void relax(int, int, int);
+        void push(int, int);
+        bool pop(int &, int &);
+};
+
+SearchContext::SearchContext()
+{
+    this -> generation = 0;
+}
+
+bool SearchContext::isSeen(int state) const
+{
+    return this -> seen[state] == this -> generation;
+}
+
+int SearchContext::getDist(int state) const
+{
+    return isSeen(state) ? this -> dist[state] : -1;
+}
+
+int SearchContext::getParent(int state) const
+{
+    return isSeen(state) ? this -> parent[state] : -1;
+}
+
+// the arrays only grow; they are cleared once per 2^32 searches when the counter wraps
+
+void SearchContext::begin(int states, int maxWeight)
+{
+    if ((int) this -> seen.size() < states)
+    {
+        this -> seen.resize(states, 0);
+        this -> dist.resize(states);
+        this -> parent.resize(states);
+    }
+    this -> generation++;
+    if (this -> generation == 0)
+    {
+        std::fill(this -> seen.begin(), this -> seen.end(), 0);
+        this -> generation = 1;
+    }
+    this -> queue.setMaxWeight(maxWeight);
+}
+
+void SearchContext::relax(int state, int d, int p)
+{
+    this -> seen[state] = this -> generation;
+    this -> dist[state] = d;
+    this -> parent[state] = p;
+}
+
+void SearchContext::push(int state, int key)
+{
+    this -> queue.push(state, key);
+}
+
+bool SearchContext::pop(int & state, int & key)
+{
+    return this -> queue.pop(state, key);
+}
+
+// a fixed set of contexts claimed with one compare-exchange each (no mutex);
+// when all are busy a temporary context is made for that query and freed after it
+
+class ContextPool
+{
+    private: // data elements
+        std::vector<std::unique_ptr<SearchContext>> contexts;
+        std::unique_ptr<std::atomic<bool>[]> busy;
+        int size;
+
+    public:
+        ContextPool(int);
+        ContextPool(const ContextPool &) = delete;
+        ContextPool & operator=(const ContextPool &) = delete;
+
+    public:
+        SearchContext * acquire();
+        void release(SearchContext *);
+};
+
+ContextPool::ContextPool(int n)
+{
+    this -> size = std::max(1, n);
+    this -> busy.reset(new std::atomic<bool>[this -> size]);
+    for (int i = 0; i < this -> size; i++)
+    {
+        this -> contexts.push_back(std::unique_ptr<SearchContext>(new SearchContext()));
+        this -> busy[i].store(false);
+    }
+}
+
+// threads start probing at different slots so they rarely collide
+
+SearchContext * ContextPool::acquire()
+{
+    int first = (int) (std::hash<std::thread::id>()(std::this_thread::get_id()) % (size_t) this -> size);
+    for (int k = 0; k < this -> size; k++)
+    {
+        int i = (first + k) % this -> size;
+        bool expected = false;
+        if (!this -> busy[i].load(std::memory_order_relaxed) &&
+            this -> busy[i].compare_exchange_strong(expected, true, std::memory_order_acquire))
+            return this -> contexts[i].get();
+    }
+    return new SearchContext();
+}
+
+void ContextPool::release(SearchContext * context)
+{
+    for (int i = 0; i < this -> size; i++)
+        if (this -> contexts[i].get() == context)
+        {
+            this -> busy[i].store(false, std::memory_order_release);
+            return;
+        }
+    delete context;
+}
+
+// coffee route queries against a shared graph; const methods are safe to call
+// from any number of threads at once
+
+class SharedPlanner
+{
+    private: // data elements
+        SharedGraph graph;
+        mutable ContextPool pool;
+
+    public:
+        SharedPlanner(SharedGraph, int);
+
+    public: // accessors
+        const SharedGraph & getGraph() const;
+
+    public: // queries
+        int coffeeRoute(int, int, std::vector<int> &) const;
+        int coffeeRoute(int, int, std::vector<int> &, const QueryOverlay &) const;
+        SearchResult coffeeRoute(int, int, std::vector<int> &, SearchLimit &) const;
+        static int coffeeRoute(const FloorGraph &, SearchContext &, int, int, std::vector<int> &);
+        static int coffeeRoute(const FloorGraph &, SearchContext &, int, int, std::vector<int> &, const QueryOverlay *);
+        static int coffeeRoute(const FloorGraph &, SearchContext &, int, int, std::vector<int> &, const QueryOverlay *, SearchLimit *);
+};
+
+SharedPlanner::SharedPlanner(SharedGraph g, int contexts) : pool(contexts)
+{
+    this -> graph = g;
+}
+
+const SharedGraph & SharedPlanner::getGraph() const
+{
+    return this -> graph;
+}
+
+int SharedPlanner::coffeeRoute(int start, int goal, std::vector<int> & route) const
+{
+    SearchContext * context = this -> pool.acquire();
+    int rv = coffeeRoute(*(this -> graph), *context, start, goal, route, nullptr);
+    this -> pool.release(context);
+    return rv;
+}
+
+// overlay closes cells and passages for this query only
+
+int SharedPlanner::coffeeRoute(int start, int goal, std::vector<int> & route, const QueryOverlay & overlay) const
+{
+    SearchContext * context = this -> pool.acquire();
+    int rv = coffeeRoute(*(this -> graph), *context, start, goal, route, & overlay);
+    this -> pool.release(context);
+    return rv;
+}
+
+// limit carries this query's deadline and cancellation token
+
+SearchResult SharedPlanner::coffeeRoute(int start, int goal, std::vector<int> & route, SearchLimit & limit) const
+{
+    SearchContext * context = this -> pool.acquire();
+    int rv = coffeeRoute(*(this -> graph), *context, start, goal, route, nullptr, & limit);
+    this -> pool.release(context);
+    return limit.finish(rv);
+}
+
+// DijkstraPlanner::coffeeRoute with all mutable state in the context
+
+int SharedPlanner::coffeeRoute(const FloorGraph & g, SearchContext & context, int start, int goal, std::vector<int> & route)
+{
+    return coffeeRoute(g, context, start, goal, route, nullptr);
+}
+
+int SharedPlanner::coffeeRoute(const FloorGraph & g, SearchContext & context, int start, int goal, std::vector<int> & route, const QueryOverlay * overlay)
+{
+    return coffeeRoute(g, context, start, goal, route, overlay, nullptr);
+}
+
+// overlay and limit are nullptr for an unrestricted search
+
+int SharedPlanner::coffeeRoute(const FloorGraph & g, SearchContext & context, int start, int goal, std::vector<int> & route, const QueryOverlay * overlay, SearchLimit * limit)
+{
+    route.clear();
+    int vCount = g.getVertexCount();
+    if (start < 0 || start >= vCount || goal < 0 || goal >= vCount)
+        return -1;
+    if (overlay != nullptr && overlay -> isVertexBlocked(start))
+        return -1;
+    int source = start + (g.getVertex(start).getC() ? vCount : 0);
+    int target = goal + vCount;
+    context.begin(2 * vCount, g.getMaxWeight());
+    context.relax(source, 0, -1);
+    context.push(source, 0);
+
+    int u;
+    int key;
+    while (context.pop(u, key))
+    {
+        if (key != context.getDist(u))
+            continue;
+        if (limit != nullptr && limit -> shouldStop())
+            return -1;
+        if (u == target)
+        {
+            for (int s = target; s >= 0; s = context.getParent(s))
+                route.push_back(s % vCount);
+            std::reverse(route.begin(), route.end());
+            return key;
+        }
+
+        int layer = (u >= vCount) ? vCount : 0;
+        int pivot = u - layer;
+        for (int e = g.getFirstEdge(pivot); e < g.getLastEdge(pivot); e++)
+        {
+            int v = g.getTarget(e);
+            if (overlay != nullptr && !overlay -> allows(e, v))
+                continue;
+            int next = v + ((layer > 0 || g.getVertex(v).getC()) ? vCount : 0);
+            int nd = key + g.getWeight(e);
+            if (!context.isSeen(next) || nd < context.getDist(next))
+            {
+                context.relax(next, nd, u);
+                context.push(next, nd);
+            }
+        }
+    }
+    return -1;
+}
+
+void runSharedGraph()
+{
+    std::cout << "Shared graph testing will start.";
+
+    FloorMap floor;
+    FloorGenerator::generate("open", 200, 200, 6, 40, floor);
+    SharedPlanner planner(makeSharedGraph(floor), 8);
+    const FloorGraph & graph = *(planner.getGraph());
+
+    const int THREADS = 8;
+    const int QUERIES = 100;
+    std::vector<long long> totals(THREADS, 0);
+    std::vector<std::thread> workers;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (int t = 0; t < THREADS; t++)
+        workers.push_back(std::thread([&planner, &graph, &totals, t]()
+        {
+            FloorGenerator queries(1000 + t);
+            std::vector<int> route;
+            for (int q = 0; q < QUERIES; q++)
+            {
+                int length = planner.coffeeRoute(queries.below(graph.getVertexCount()), queries.below(graph.getVertexCount()), route);
+                totals[t] += std::max(0, length);
+            }
+        }));
+    for (size_t t = 0; t < workers.size(); t++)
+        workers[t].join();
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+    // the same queries on one thread with a private planner
+
+    DijkstraPlanner single(graph);
+    int mismatches = 0;
+    std::vector<int> route;
+    for (int t = 0; t < THREADS; t++)
+    {
+        FloorGenerator queries(1000 + t);
+        long long total = 0;
+        for (int q = 0; q < QUERIES; q++)
+        {
+            int start = queries.below(graph.getVertexCount());
+            int goal = queries.below(graph.getVertexCount());
+            total += std::max(0, single.coffeeRoute(start, goal, route));
+        }
+        if (total != totals[t])
+            mismatches++;
+    }
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+    std::cout << "\n" << graph.getVertexCount() << " vertices, " << THREADS << " threads x " << QUERIES << " queries.";
+    std::cout << "\nShared graph: " << std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count() << " ms.";
+    std::cout << "\nOne thread: " << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count() << " ms, ";
+    std::cout << mismatches << " mismatched threads.";
+}
+
+#endif /* sharedGraph_h */
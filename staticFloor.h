@@ -0,0 +1,264 @@
+//  staticFloor.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Compile-time graph construction for fixed built-in floors.
+
+#ifndef staticFloor_h
+#define staticFloor_h
+#include <cstdint>
+#include "graphSolution.h"
+
+// the grid uses the FloorMap characters: H rows of W cells separated by '\n'
+// vertex ids follow the onboarding order of makeEdgesAndVertices (columns left to right,
+// each column bottom to top), so ids agree with U and with FloorGraph built from U
+// everything is constexpr: a floor declared constexpr costs nothing at startup and never allocates
+
+template <int W, int H>
+class StaticFloor
+{
+    public: // data elements
+        int vertexCount = 0;
+        int edgeCount = 0;
+        int xs [W * H] = {};
+        int ys [W * H] = {};
+        bool coffee [W * H] = {};
+        int cellId [W * H] = {};
+        int offsets [W * H + 1] = {};
+        int targets [4 * W * H] = {};
+        int weights [4 * W * H] = {};
+
+    public:
+        constexpr StaticFloor(const char *);
+
+    public: // accessors
+        constexpr int findId(int, int) const;
+
+    private:
+        static constexpr bool isOpen(char);
+        static constexpr int cost(char);
+};
+
+template <int W, int H>
+constexpr bool StaticFloor<W, H>::isOpen(char c)
+{
+    return c == '.' || c == 'C' || (c >= '1' && c <= '9');
+}
+
+template <int W, int H>
+constexpr int StaticFloor<W, H>::cost(char c)
+{
+    return (c >= '1' && c <= '9') ? c - '0' : 1;
+}
+
+template <int W, int H>
+constexpr StaticFloor<W, H>::StaticFloor(const char * grid)
+{
+    for (int x = 0; x < W; x++)
+        for (int y = 0; y < H; y++)
+        {
+            char c = grid[y * (W + 1) + x];
+            this -> cellId[y * W + x] = -1;
+            if (isOpen(c))
+            {
+                this -> xs[this -> vertexCount] = x;
+                this -> ys[this -> vertexCount] = y;
+                this -> coffee[this -> vertexCount] = (c == 'C');
+                this -> cellId[y * W + x] = this -> vertexCount;
+                this -> vertexCount++;
+            }
+        }
+
+    const int dx [4] = { -1, 0, 1, 0 };
+    const int dy [4] = { 0, -1, 0, 1 };
+    for (int v = 0; v < this -> vertexCount; v++)
+    {
+        this -> offsets[v] = this -> edgeCount;
+        char here = grid[this -> ys[v] * (W + 1) + this -> xs[v]];
+        for (int d = 0; d < 4; d++)
+        {
+            int nx = this -> xs[v] + dx[d];
+            int ny = this -> ys[v] + dy[d];
+            if (nx < 0 || ny < 0 || nx >= W || ny >= H)
+                continue;
+            char there = grid[ny * (W + 1) + nx];
+            if (!isOpen(there))
+                continue;
+            this -> targets[this -> edgeCount] = this -> cellId[ny * W + nx];
+            this -> weights[this -> edgeCount] = (cost(here) > cost(there)) ? cost(here) : cost(there);
+            this -> edgeCount++;
+        }
+    }
+    this -> offsets[this -> vertexCount] = this -> edgeCount;
+}
+
+template <int W, int H>
+constexpr int StaticFloor<W, H>::findId(int x, int y) const
+{
+    if (x < 0 || y < 0 || x >= W || y >= H)
+        return -1;
+    return this -> cellId[y * W + x];
+}
+
+// all-pairs distance table, 16-bit, computed at compile time by array-scan Dijkstra
+// (O(V^3), meant for small fixed floors)
+
+template <int W, int H>
+class StaticDistances
+{
+    public: // data elements
+        const StaticFloor<W, H> * floor = nullptr;
+        uint16_t dist [W * H][W * H] = {};
+
+    public:
+        static constexpr uint16_t UNREACHED = 0xffff;
+
+    public:
+        constexpr StaticDistances(const StaticFloor<W, H> &);
+
+    public: // queries
+        constexpr int distance(int, int) const;
+        constexpr int coffeeDistance(int, int) const;
+        constexpr int route(int, int, int *, int) const;
+        constexpr int coffeeRoute(int, int, int *, int) const;
+};
+
+template <int W, int H>
+constexpr StaticDistances<W, H>::StaticDistances(const StaticFloor<W, H> & f)
+{
+    this -> floor = & f;
+    int vCount = f.vertexCount;
+    for (int s = 0; s < vCount; s++)
+    {
+        bool done [W * H] = {};
+        for (int v = 0; v < vCount; v++)
+            this -> dist[s][v] = UNREACHED;
+        this -> dist[s][s] = 0;
+        for (int round = 0; round < vCount; round++)
+        {
+            int u = -1;
+            for (int v = 0; v < vCount; v++)
+                if (!done[v] && this -> dist[s][v] != UNREACHED && (u < 0 || this -> dist[s][v] < this -> dist[s][u]))
+                    u = v;
+            if (u < 0)
+                break;
+            done[u] = true;
+            for (int e = f.offsets[u]; e < f.offsets[u + 1]; e++)
+            {
+                int v = f.targets[e];
+                int nd = this -> dist[s][u] + f.weights[e];
+                if (nd < this -> dist[s][v])
+                    this -> dist[s][v] = (uint16_t) nd;
+            }
+        }
+    }
+}
+
+// -1 if unreachable
+
+template <int W, int H>
+constexpr int StaticDistances<W, H>::distance(int s, int t) const
+{
+    return (this -> dist[s][t] == UNREACHED) ? -1 : this -> dist[s][t];
+}
+
+// start -> any coffee station -> goal, -1 if there is none
+
+template <int W, int H>
+constexpr int StaticDistances<W, H>::coffeeDistance(int s, int g) const
+{
+    int rv = -1;
+    for (int c = 0; c < this -> floor -> vertexCount; c++)
+        if (this -> floor -> coffee[c] && distance(s, c) >= 0 && distance(c, g) >= 0)
+            if (rv < 0 || distance(s, c) + distance(c, g) < rv)
+                rv = distance(s, c) + distance(c, g);
+    return rv;
+}
+
+// writes the vertex ids of a shortest s -> t route (both inclusive) into out
+// returns the number written, or -1 if there is no route or it does not fit
+
+template <int W, int H>
+constexpr int StaticDistances<W, H>::route(int s, int t, int * out, int capacity) const
+{
+    if (distance(s, t) < 0 || capacity < 1)
+        return -1;
+    int count = 0;
+    out[count++] = s;
+    int u = s;
+    while (u != t)
+    {
+        int next = -1;
+        for (int e = this -> floor -> offsets[u]; e < this -> floor -> offsets[u + 1] && next < 0; e++)
+        {
+            int v = this -> floor -> targets[e];
+            if (this -> dist[v][t] != UNREACHED && this -> dist[v][t] + this -> floor -> weights[e] == this -> dist[u][t])
+                next = v;
+        }
+        if (next < 0 || count >= capacity)
+            return -1;
+        out[count++] = next;
+        u = next;
+    }
+    return count;
+}
+
+template <int W, int H>
+constexpr int StaticDistances<W, H>::coffeeRoute(int s, int g, int * out, int capacity) const
+{
+    int best = -1;
+    for (int c = 0; c < this -> floor -> vertexCount; c++)
+        if (this -> floor -> coffee[c] && distance(s, c) >= 0 && distance(c, g) >= 0)
+            if (best < 0 || distance(s, c) + distance(c, g) < distance(s, best) + distance(best, g))
+                best = c;
+    if (best < 0)
+        return -1;
+    int first = route(s, best, out, capacity);
+    if (first < 0)
+        return -1;
+    int second = route(best, g, out + first - 1, capacity - first + 1);
+    if (second < 0)
+        return -1;
+    return first + second - 1;
+}
+
+// the floor built by Edge::makeEdgesAndVertices, as compile-time data
+
+constexpr const char staticDemoGrid [] = "C...C....\n"
+                                         ".#.......\n"
+                                         ".#.......\n"
+                                         ".#####...\n"
+                                         ".#...#.C.\n"
+                                         ".........\n";
+
+constexpr StaticFloor<9, 6> staticDemoFloor(staticDemoGrid);
+constexpr StaticDistances<9, 6> staticDemoDistances(staticDemoFloor);
+
+static_assert(staticDemoFloor.vertexCount == 45, "demo floor has 45 vertices");
+static_assert(staticDemoFloor.findId(3, 2) == 15 && staticDemoFloor.findId(3, 4) == 16, "ids follow onboarding order");
+static_assert(staticDemoDistances.coffeeDistance(15, 16) == 12, "start -> coffee -> goal is 12 steps");
+
+void runStaticFloor()
+{
+    std::cout << "Static floor testing will start.";
+    std::cout << "\n" << staticDemoFloor.vertexCount << " vertices, " << staticDemoFloor.edgeCount << " directed edges, built at compile time.";
+
+    int route [2 * 9 * 6];
+    int start = staticDemoFloor.findId(3, 2);
+    int goal = staticDemoFloor.findId(3, 4);
+    int count = staticDemoDistances.coffeeRoute(start, goal, route, 2 * 9 * 6);
+    std::cout << "\nCoffee route of length " << staticDemoDistances.coffeeDistance(start, goal) << ":";
+    std::cout << "\n{ ";
+    for (int i = 0; i < count; i++)
+    {
+        Vertex v;
+        v.setXY(staticDemoFloor.xs[route[i]], staticDemoFloor.ys[route[i]]);
+        if (staticDemoFloor.coffee[route[i]])
+            v.placeC();
+        v.printVertex();
+        if (i + 1 < count)
+            std::cout << ", ";
+    }
+    std::cout << " }";
+}
+
+#endif /* staticFloor_h */
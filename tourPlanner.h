@@ -0,0 +1,459 @@
+//  tourPlanner.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Multi-order delivery tours: one start, several coffee pickups, several desks.
+
+#ifndef tourPlanner_h
+#define tourPlanner_h
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "floorGraph.h"
+#include "floorMap.h"
+#include "searchLimit.h"
+#include "weightedSearch.h"
+
+// node 0 of the distance matrix is the start,
+// nodes 1 .. pickupCount are pickups and the remaining nodes are desks
+// a desk may only be visited while the robot carries an undelivered coffee
+
+class TourPlanner
+{
+    private: // data elements
+        const FloorGraph * graph;
+        std::vector<int> nodes;
+        int pickupCount;
+        std::vector<int> matrix;
+        std::vector<std::vector<int>> parents;
+        std::vector<int> order;
+        int tourLength;
+        bool exact;
+        long long matrixMicros;
+        long long solveMicros;
+
+    public: // stops solved exactly by Held-Karp, heuristic above this
+        static constexpr int EXACT_STOP_LIMIT = 16;
+        static constexpr int UNREACHABLE = 1 << 29;
+
+    public:
+        TourPlanner(const FloorGraph &);
+
+    public: // accessors
+        std::vector<int> getOrder() const;
+        int getTourLength() const;
+        bool isExact() const;
+        long long getMatrixMicros() const;
+        long long getSolveMicros() const;
+        long long getTourMicros() const;
+
+    public: // plan
+        bool planTour(int, const std::vector<int> &, const std::vector<int> &);
+        SearchResult planTour(int, const std::vector<int> &, const std::vector<int> &, SearchLimit &);
+        void buildRoute(std::vector<int> &) const;
+
+    public: // print to console
+        void printTour() const;
+
+    private:
+        int distance(int, int) const;
+        bool plan(int, const std::vector<int> &, const std::vector<int> &, SearchLimit *);
+        void buildMatrix(SearchLimit *);
+        bool solveExact(SearchLimit *);
+        bool solveHeuristic(SearchLimit *);
+        bool isFeasible(const std::vector<int> &) const;
+        int orderLength(const std::vector<int> &) const;
+};
+
+TourPlanner::TourPlanner(const FloorGraph & g)
+{
+    this -> graph = & g;
+    this -> pickupCount = 0;
+    this -> tourLength = -1;
+    this -> exact = false;
+    this -> matrixMicros = 0;
+    this -> solveMicros = 0;
+}
+
+std::vector<int> TourPlanner::getOrder() const
+{
+    std::vector<int> rv;
+    for (size_t i = 0; i < this -> order.size(); i++)
+        rv.push_back(this -> nodes[this -> order[i]]);
+    return rv;
+}
+
+int TourPlanner::getTourLength() const
+{
+    return this -> tourLength;
+}
+
+bool TourPlanner::isExact() const
+{
+    return this -> exact;
+}
+
+long long TourPlanner::getMatrixMicros() const
+{
+    return this -> matrixMicros;
+}
+
+long long TourPlanner::getSolveMicros() const
+{
+    return this -> solveMicros;
+}
+
+long long TourPlanner::getTourMicros() const
+{
+    return this -> matrixMicros + this -> solveMicros;
+}
+
+int TourPlanner::distance(int a, int b) const
+{
+    return this -> matrix[(size_t) a * this -> nodes.size() + b];
+}
+
+// returns false if some desk cannot be served (too few pickups or unreachable stops)
+
+bool TourPlanner::planTour(int start, const std::vector<int> & pickups, const std::vector<int> & desks)
+{
+    return plan(start, pickups, desks, nullptr);
+}
+
+// under a deadline or cancellation token; the result's length is the tour length
+// or -1; a heuristic tour cut short during 2-opt keeps the feasible order it has
+// (getOrder() and buildRoute() still work), anything earlier gives no tour
+
+SearchResult TourPlanner::planTour(int start, const std::vector<int> & pickups, const std::vector<int> & desks, SearchLimit & limit)
+{
+    bool rv = plan(start, pickups, desks, & limit);
+    return limit.finish(rv ? this -> tourLength : -1);
+}
+
+// limit is nullptr for an unrestricted plan; it is checked per matrix row on the
+// calling thread, per subset in Held-Karp and per 2-opt pass and position
+
+bool TourPlanner::plan(int start, const std::vector<int> & pickups, const std::vector<int> & desks, SearchLimit * limit)
+{
+    this -> nodes.clear();
+    this -> nodes.push_back(start);
+    this -> nodes.insert(this -> nodes.end(), pickups.begin(), pickups.end());
+    this -> nodes.insert(this -> nodes.end(), desks.begin(), desks.end());
+    this -> pickupCount = (int) pickups.size();
+    this -> order.clear();
+    this -> tourLength = -1;
+    this -> exact = false;
+    this -> matrixMicros = 0;
+    this -> solveMicros = 0;
+
+    if (pickups.size() < desks.size())
+        return false;
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    buildMatrix(limit);
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+    bool rv;
+    if (limit != nullptr && limit -> isStopped())
+        rv = false;
+    else if ((int) this -> nodes.size() - 1 <= EXACT_STOP_LIMIT)
+        rv = solveExact(limit);
+    else
+        rv = solveHeuristic(limit);
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+    this -> matrixMicros = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+    this -> solveMicros = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+    return rv;
+}
+
+// one BFS per node (Dijkstra on weighted floors), spread over the hardware threads
+// every worker keeps its own buffers; rows of the matrix are disjoint
+// only the calling thread reads limit (it is not shared between threads); once it
+// says stop, no worker starts another row
+
+void TourPlanner::buildMatrix(SearchLimit * limit)
+{
+    int count = (int) this -> nodes.size();
+    this -> matrix.assign((size_t) count * count, UNREACHABLE);
+    this -> parents.assign(count, std::vector<int>());
+
+    std::atomic<int> nextNode(0);
+    const FloorGraph * g = this -> graph;
+    std::vector<int> & m = this -> matrix;
+    std::vector<int> & nd = this -> nodes;
+    std::vector<std::vector<int>> & pt = this -> parents;
+    std::atomic<bool> abandoned(false);
+
+    auto worker = [&](SearchLimit * own)
+    {
+        std::vector<int> dist;
+        DijkstraPlanner dijkstra(*g);
+        for (int s = nextNode++; s < count && !abandoned; s = nextNode++)
+        {
+            if (own != nullptr && own -> checkNow())
+            {
+                abandoned = true;
+                break;
+            }
+            if (g -> isWeighted())
+                dijkstra.distances(nd[s], dist, pt[s]);
+            else
+                g -> bfs(nd[s], dist, pt[s]);
+            for (int t = 0; t < count; t++)
+                if (nd[t] >= 0 && dist[nd[t]] >= 0)
+                    m[(size_t) s * count + t] = dist[nd[t]];
+        }
+    };
+
+    int threadCount = (int) std::thread::hardware_concurrency();
+    threadCount = std::max(1, std::min(threadCount, count));
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threadCount; i++)
+        pool.push_back(std::thread(worker, nullptr));
+    worker(limit);
+    for (size_t i = 0; i < pool.size(); i++)
+        pool[i].join();
+}
+
+// Held-Karp over subsets of stops
+// dp[mask][j] is the shortest walk from the start visiting exactly mask and ending at stop j
+
+bool TourPlanner::solveExact(SearchLimit * limit)
+{
+    int k = (int) this -> nodes.size() - 1;
+    if (k == 0)
+    {
+        this -> tourLength = 0;
+        this -> exact = true;
+        return true;
+    }
+
+    unsigned pickupMask = (1u << this -> pickupCount) - 1;
+    unsigned deskMask = ((1u << k) - 1) & ~pickupMask;
+    size_t states = (size_t) 1 << k;
+    std::vector<int> dp(states * k, UNREACHABLE);
+    std::vector<signed char> from(states * k, -1);
+
+    for (int j = 0; j < this -> pickupCount; j++)
+        dp[((size_t) 1 << j) * k + j] = distance(0, j + 1);
+
+    for (size_t mask = 1; mask < states; mask++)
+    {
+        if (limit != nullptr && limit -> shouldStop())
+            return false;
+        int carried = __builtin_popcount((unsigned) mask & pickupMask) -
+                      __builtin_popcount((unsigned) mask & deskMask);
+        for (int j = 0; j < k; j++)
+        {
+            int base = dp[mask * k + j];
+            if (base >= UNREACHABLE)
+                continue;
+            for (int t = 0; t < k; t++)
+            {
+                if (mask & ((size_t) 1 << t))
+                    continue;
+                if (t >= this -> pickupCount && carried <= 0)
+                    continue;
+                int step = distance(j + 1, t + 1);
+                if (step >= UNREACHABLE)
+                    continue;
+                size_t next = (mask | ((size_t) 1 << t)) * k + t;
+                if (base + step < dp[next])
+                {
+                    dp[next] = base + step;
+                    from[next] = (signed char) j;
+                }
+            }
+        }
+    }
+
+    size_t full = states - 1;
+    int best = UNREACHABLE;
+    int last = -1;
+    for (int j = 0; j < k; j++)
+        if (dp[full * k + j] < best)
+        {
+            best = dp[full * k + j];
+            last = j;
+        }
+    if (last < 0)
+        return false;
+
+    size_t mask = full;
+    while (last >= 0)
+    {
+        this -> order.push_back(last + 1);
+        int prev = from[mask * k + last];
+        mask &= ~((size_t) 1 << last);
+        last = prev;
+    }
+    std::reverse(this -> order.begin(), this -> order.end());
+    this -> tourLength = best;
+    this -> exact = true;
+    return true;
+}
+
+// nearest feasible stop first, then 2-opt moves that keep the tour feasible
+
+bool TourPlanner::solveHeuristic(SearchLimit * limit)
+{
+    int k = (int) this -> nodes.size() - 1;
+    std::vector<bool> used(k + 1, false);
+    int carried = 0;
+    int current = 0;
+    for (int step = 0; step < k; step++)
+    {
+        int best = -1;
+        for (int t = 1; t <= k; t++)
+        {
+            if (used[t] || (t > this -> pickupCount && carried <= 0))
+                continue;
+            if (best < 0 || distance(current, t) < distance(current, best))
+                best = t;
+        }
+        if (best < 0 || distance(current, best) >= UNREACHABLE)
+            return false;
+        used[best] = true;
+        carried += (best <= this -> pickupCount) ? 1 : -1;
+        this -> order.push_back(best);
+        current = best;
+    }
+
+    bool improved = true;
+    while (improved && !(limit != nullptr && limit -> checkNow()))
+    {
+        improved = false;
+        for (int i = 0; i < k - 1 && !(limit != nullptr && limit -> shouldStop()); i++)
+            for (int j = i + 1; j < k; j++)
+            {
+                int before = (i == 0) ? 0 : this -> order[i - 1];
+                int oldCost = distance(before, this -> order[i]);
+                int newCost = distance(before, this -> order[j]);
+                if (j + 1 < k)
+                {
+                    oldCost += distance(this -> order[j], this -> order[j + 1]);
+                    newCost += distance(this -> order[i], this -> order[j + 1]);
+                }
+                if (newCost >= oldCost)
+                    continue;
+                std::reverse(this -> order.begin() + i, this -> order.begin() + j + 1);
+                if (isFeasible(this -> order))
+                    improved = true;
+                else
+                    std::reverse(this -> order.begin() + i, this -> order.begin() + j + 1);
+            }
+    }
+
+    this -> tourLength = orderLength(this -> order);
+    this -> exact = false;
+    return this -> tourLength < UNREACHABLE;
+}
+
+bool TourPlanner::isFeasible(const std::vector<int> & candidate) const
+{
+    int carried = 0;
+    for (size_t i = 0; i < candidate.size(); i++)
+    {
+        if (candidate[i] <= this -> pickupCount)
+            carried++;
+        else if (--carried < 0)
+            return false;
+    }
+    return true;
+}
+
+int TourPlanner::orderLength(const std::vector<int> & candidate) const
+{
+    int rv = 0;
+    int current = 0;
+    for (size_t i = 0; i < candidate.size(); i++)
+    {
+        int step = distance(current, candidate[i]);
+        if (step >= UNREACHABLE)
+            return UNREACHABLE;
+        rv += step;
+        current = candidate[i];
+    }
+    return rv;
+}
+
+// full vertex route of the planned tour, start included
+
+void TourPlanner::buildRoute(std::vector<int> & route) const
+{
+    route.clear();
+    if (this -> tourLength < 0)
+        return;
+    route.push_back(this -> nodes[0]);
+    int current = 0;
+    for (size_t i = 0; i < this -> order.size(); i++)
+    {
+        int next = this -> order[i];
+        std::vector<int> leg;
+        FloorGraph::tracePath(this -> nodes[current], this -> nodes[next], this -> parents[current], leg);
+        if (leg.size() > 1)
+            route.insert(route.end(), leg.begin() + 1, leg.end());
+        current = next;
+    }
+}
+
+void TourPlanner::printTour() const
+{
+    if (this -> tourLength < 0)
+    {
+        std::cout << "\nNo tour found.";
+        return;
+    }
+    std::cout << "\nTour of " << this -> order.size() << " stops, length " << this -> tourLength;
+    std::cout << (this -> exact ? " (exact)." : " (heuristic).");
+    for (size_t i = 0; i < this -> order.size(); i++)
+    {
+        Vertex v = this -> graph -> getVertex(this -> nodes[this -> order[i]]);
+        std::cout << "\n  " << i + 1 << ".\t";
+        std::cout << (this -> order[i] <= this -> pickupCount ? "pickup " : "desk   ");
+        v.printVertex();
+    }
+    std::cout << "\nDistance matrix: " << this -> matrixMicros << " us, ";
+    std::cout << "order: " << this -> solveMicros << " us, ";
+    std::cout << "tour: " << getTourMicros() << " us.";
+}
+
+void runTourPlanner()
+{
+    std::cout << "Tour planning will start.";
+    std::vector<Vertex> U;
+    std::vector<Edge> edgeVector;
+    FloorMap::demoFloor().makeEdgesAndVertices(U, edgeVector);
+
+    FloorGraph graph(U, edgeVector);
+    TourPlanner planner(graph);
+
+    std::vector<int> pickups = graph.getCoffeeIds();
+    std::vector<int> desks;
+    desks.push_back(graph.findId(3, 4));
+    desks.push_back(graph.findId(8, 5));
+    desks.push_back(graph.findId(0, 5));
+
+    planner.planTour(graph.findId(3, 2), pickups, desks);
+    planner.printTour();
+    std::vector<int> route;
+    planner.buildRoute(route);
+    graph.printRoute(route);
+
+    // beyond EXACT_STOP_LIMIT: every other vertex is a pickup, the rest are desks
+
+    pickups.clear();
+    desks.clear();
+    for (int i = 1; i < graph.getVertexCount() && desks.size() < 12; i++)
+    {
+        if (i % 2)
+            pickups.push_back(i);
+        else
+            desks.push_back(i);
+    }
+    planner.planTour(0, pickups, desks);
+    planner.printTour();
+}
+
+#endif /* tourPlanner_h */
@@ -0,0 +1,191 @@
+//  vertexOrder.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Locality-preserving vertex numbering along a Morton or Hilbert curve.
+
+#ifndef vertexOrder_h
+#define vertexOrder_h
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "floorGenerator.h"
+#include "floorGraph.h"
+#include "parallelBuild.h"
+#include "searchMetrics.h"
+#include "weightedSearch.h"
+
+// makeEdgesAndVertices numbers cells column by column, so a cell and its left
+// and right neighbours are a whole column apart in every per-vertex array;
+// along a space-filling curve most neighbours get nearby ids instead
+//   column   the onboarding order (x outer, y inner), unchanged
+//   morton   bits of x and y interleaved (Z order)
+//   hilbert  Hilbert curve index, no jumps between consecutive cells
+// ids only change meaning: getVertex(id) still gives the cell's (x, y) and
+// findId(x, y) its new id
+
+class VertexOrder
+{
+    public:
+        static uint64_t mortonKey(uint32_t, uint32_t);
+        static uint64_t hilbertKey(uint32_t, uint32_t, int);
+        static bool curveIds(const FloorGraph &, const std::string &, std::vector<int> &);
+        static bool renumber(FloorGraph &, const std::string &, std::vector<int> &);
+        static double sharedLineShare(const FloorGraph &);
+};
+
+// spread the low 32 bits of x over the even bits, y over the odd bits
+
+uint64_t VertexOrder::mortonKey(uint32_t x, uint32_t y)
+{
+    auto spread = [](uint64_t v)
+    {
+        v = (v | (v << 16)) & 0x0000ffff0000ffffULL;
+        v = (v | (v << 8)) & 0x00ff00ff00ff00ffULL;
+        v = (v | (v << 4)) & 0x0f0f0f0f0f0f0f0fULL;
+        v = (v | (v << 2)) & 0x3333333333333333ULL;
+        v = (v | (v << 1)) & 0x5555555555555555ULL;
+        return v;
+    };
+    return spread(x) | (spread(y) << 1);
+}
+
+// index of (x, y) on the Hilbert curve filling a 2^bits square
+
+uint64_t VertexOrder::hilbertKey(uint32_t x, uint32_t y, int bits)
+{
+    uint64_t rv = 0;
+    for (uint32_t s = 1u << (bits - 1); s > 0; s >>= 1)
+    {
+        uint32_t rx = (x & s) ? 1 : 0;
+        uint32_t ry = (y & s) ? 1 : 0;
+        rv += (uint64_t) s * s * ((3 * rx) ^ ry);
+        if (ry == 0)
+        {
+            if (rx == 1)
+            {
+                x = s - 1 - (x & (s - 1));
+                y = s - 1 - (y & (s - 1));
+            }
+            std::swap(x, y);
+        }
+        x &= s - 1;
+        y &= s - 1;
+    }
+    return rv;
+}
+
+// newIds[v] is v's position along the curve; false for an unknown curve name
+
+bool VertexOrder::curveIds(const FloorGraph & g, const std::string & curve, std::vector<int> & newIds)
+{
+    int vCount = g.getVertexCount();
+    newIds.resize(vCount);
+    if (curve == "column")
+    {
+        for (int v = 0; v < vCount; v++)
+            newIds[v] = v;
+        return true;
+    }
+    if (curve != "morton" && curve != "hilbert")
+        return false;
+
+    int bits = 1;
+    while ((1 << bits) < std::max(g.getWidth(), g.getHeight()))
+        bits++;
+    std::vector<std::pair<uint64_t, int>> keys(vCount);
+    for (int v = 0; v < vCount; v++)
+    {
+        uint32_t x = (uint32_t) (g.getVertex(v).getX() - g.getMinX());
+        uint32_t y = (uint32_t) (g.getVertex(v).getY() - g.getMinY());
+        keys[v].first = (curve == "morton") ? mortonKey(x, y) : hilbertKey(x, y, bits);
+        keys[v].second = v;
+    }
+    std::sort(keys.begin(), keys.end());
+    for (int i = 0; i < vCount; i++)
+        newIds[keys[i].second] = i;
+    return true;
+}
+
+// renumbers g in place; newIds[old id] is the new id, for translating ids kept from before
+
+bool VertexOrder::renumber(FloorGraph & g, const std::string & curve, std::vector<int> & newIds)
+{
+    return curveIds(g, curve, newIds) && g.renumber(newIds);
+}
+
+// share of directed edges whose two ends fall in the same 64 byte line of an
+// int array indexed by vertex id (dist, parent, offsets): a rough count of the
+// neighbour reads a search gets without another cache miss
+
+double VertexOrder::sharedLineShare(const FloorGraph & g)
+{
+    long long shared = 0;
+    for (int v = 0; v < g.getVertexCount(); v++)
+        for (int e = g.getFirstEdge(v); e < g.getLastEdge(v); e++)
+            shared += (v / 16 == g.getTarget(e) / 16);
+    return (g.getEdgeCount() > 0) ? (double) shared / g.getEdgeCount() : 0.0;
+}
+
+// the same coffee route queries (by cell) on one floor in each numbering
+
+void runVertexOrder()
+{
+    std::cout << "Vertex order testing will start.";
+
+    FloorMap floor;
+    FloorGenerator::generate("open", 1024, 1024, 8, 44, floor);
+    FloorGenerator queries(9);
+    std::vector<std::pair<int, int>> cells;
+    while (cells.size() < 24)
+    {
+        int x = queries.below(1024);
+        int y = queries.below(1024);
+        if (floor.isOpen(x, y))
+            cells.push_back(std::make_pair(x, y));
+    }
+
+    const char * curves [3] = { "column", "morton", "hilbert" };
+    std::vector<long long> firstLengths;
+    int mismatches = 0;
+    PerfCounters perf(true);
+    for (int c = 0; c < 3; c++)
+    {
+        FloorGraph graph;
+        ParallelGraphBuilder::build(floor, graph, 1);
+        std::vector<int> newIds;
+        VertexOrder::renumber(graph, curves[c], newIds);
+
+        DijkstraPlanner planner(graph);
+        std::vector<int> route;
+        std::vector<long long> lengths;
+        long long before [PerfCounters::COUNT] = { 0, 0, 0 };
+        long long after [PerfCounters::COUNT] = { 0, 0, 0 };
+        bool hardware = perf.read(before);
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        for (size_t q = 0; q + 1 < cells.size(); q += 2)
+        {
+            int start = graph.findId(cells[q].first, cells[q].second);
+            int goal = graph.findId(cells[q + 1].first, cells[q + 1].second);
+            lengths.push_back(planner.coffeeRoute(start, goal, route));
+        }
+        std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+        hardware = perf.read(after) && hardware;
+        if (c == 0)
+            firstLengths = lengths;
+        else if (lengths != firstLengths)
+            mismatches++;
+
+        std::cout << "\n" << curves[c] << ": " << std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count() << " ms, ";
+        std::cout << (int) (100 * VertexOrder::sharedLineShare(graph) + 0.5) << "% of edges within one cache line, cache misses ";
+        if (hardware)
+            std::cout << after[2] - before[2] << ".";
+        else
+            std::cout << "n/a.";
+    }
+    std::cout << "\n" << cells.size() / 2 << " queries per order, " << mismatches << " mismatched orders.";
+}
+
+#endif /* vertexOrder_h */
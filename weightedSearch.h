@@ -0,0 +1,407 @@
+//  weightedSearch.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Dijkstra over weighted edges with a monotone bucket queue.
+
+#ifndef weightedSearch_h
+#define weightedSearch_h
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "floorGraph.h"
+#include "floorMap.h"
+#include "queryOverlay.h"
+#include "searchLimit.h"
+
+// Dial's bucket queue
+// keys popped never decrease and a pushed key is at most maxWeight above the
+// last popped key, so a ring of maxWeight + 1 buckets is enough; the ring is
+// rounded up to a power of two so a slot is key & mask rather than a division
+// a bucket pops its newest entry first, so among equal keys A* goes deeper;
+// buckets keep their capacity, so after the first query pushes and pops do not allocate
+
+class BucketQueue
+{
+    private: // data elements
+        std::vector<std::vector<int>> buckets;
+        size_t mask;
+        long long current;
+        int count;
+
+    public:
+        BucketQueue(); // default constructor
+        BucketQueue(int);
+
+    public: // accessors
+        bool isEmpty() const;
+
+    public: // mutators
+        void setMaxWeight(int);
+        void clear();
+        void push(int, int);
+        bool pop(int &, int &);
+};
+
+BucketQueue::BucketQueue()
+{
+    this -> current = -1;
+    this -> count = 0;
+    this -> mask = 1;
+    this -> buckets.resize(2);
+}
+
+BucketQueue::BucketQueue(int maxWeight)
+{
+    this -> current = -1;
+    this -> count = 0;
+    this -> mask = 1;
+    this -> buckets.resize(2);
+    setMaxWeight(maxWeight);
+}
+
+bool BucketQueue::isEmpty() const
+{
+    return this -> count == 0;
+}
+
+void BucketQueue::setMaxWeight(int maxWeight)
+{
+    clear();
+    size_t size = 2;
+    while (size < (size_t) std::max(1, maxWeight) + 1)
+        size *= 2;
+    if (this -> buckets.size() != size)
+    {
+        this -> buckets.resize(size);
+        this -> mask = size - 1;
+    }
+}
+
+void BucketQueue::clear()
+{
+    for (size_t i = 0; i < this -> buckets.size(); i++)
+        this -> buckets[i].clear();
+    this -> current = -1;
+    this -> count = 0;
+}
+
+// the first push after clear() sets the starting key, so searches may begin
+// at any key (A* begins at h of the source)
+
+void BucketQueue::push(int item, int key)
+{
+    if (this -> current < 0)
+        this -> current = key;
+    this -> buckets[(size_t) key & this -> mask].push_back(item);
+    this -> count++;
+}
+
+bool BucketQueue::pop(int & item, int & key)
+{
+    if (this -> count == 0)
+        return false;
+    size_t slot = (size_t) this -> current & this -> mask;
+    while (this -> buckets[slot].empty())
+    {
+        this -> current++;
+        slot = (size_t) this -> current & this -> mask;
+    }
+    item = this -> buckets[slot].back();
+    this -> buckets[slot].pop_back();
+    this -> count--;
+    key = (int) this -> current;
+    return true;
+}
+
+// search states are vertex ids, or in coffee mode v (no coffee yet) and v + V (coffee carried)
+// the scratch vectors are sized once and reused between queries: dist and parent
+// hold a state's values only when seen[state] is the query's generation
+
+class DijkstraPlanner
+{
+    private: // data elements
+        const FloorGraph * graph;
+        BucketQueue queue;
+        std::vector<int> dist;
+        std::vector<int> parent;
+        std::vector<uint32_t> seen;
+        uint32_t generation;
+        int settled;
+
+    public:
+        DijkstraPlanner(const FloorGraph &);
+
+    public: // accessors
+        int getSettledCount() const;
+
+    public: // queries
+        int distances(int, std::vector<int> &, std::vector<int> &);
+        int shortestPath(int, int, std::vector<int> &);
+        int coffeeRoute(int, int, std::vector<int> &);
+        int shortestPath(int, int, std::vector<int> &, const QueryOverlay &);
+        int coffeeRoute(int, int, std::vector<int> &, const QueryOverlay &);
+        SearchResult shortestPath(int, int, std::vector<int> &, SearchLimit &);
+        SearchResult coffeeRoute(int, int, std::vector<int> &, SearchLimit &);
+
+    private:
+        void touch(int);
+        int search(int, int, bool, const QueryOverlay *, SearchLimit *);
+        void traceStates(int, std::vector<int> &) const;
+};
+
+DijkstraPlanner::DijkstraPlanner(const FloorGraph & g)
+{
+    this -> graph = & g;
+    this -> settled = 0;
+    this -> generation = 0;
+    int states = 2 * g.getVertexCount();
+    this -> dist.resize(states);
+    this -> parent.resize(states);
+    this -> seen.resize(states, 0);
+}
+
+int DijkstraPlanner::getSettledCount() const
+{
+    return this -> settled;
+}
+
+// single source distances to every vertex (-1 if unreachable)
+// returns the number of vertices reached
+
+int DijkstraPlanner::distances(int source, std::vector<int> & distOut, std::vector<int> & parentOut)
+{
+    int vCount = this -> graph -> getVertexCount();
+    search(source, -1, false, nullptr, nullptr);
+    distOut.assign(vCount, -1);
+    parentOut.assign(vCount, -1);
+    for (int v = 0; v < vCount; v++)
+        if (this -> seen[v] == this -> generation)
+        {
+            distOut[v] = this -> dist[v];
+            parentOut[v] = this -> parent[v];
+        }
+    return this -> settled;
+}
+
+// returns the route length, or -1 if target cannot be reached
+
+int DijkstraPlanner::shortestPath(int source, int target, std::vector<int> & route)
+{
+    route.clear();
+    int vCount = this -> graph -> getVertexCount();
+    if (source < 0 || source >= vCount || target < 0 || target >= vCount)
+        return -1;
+    int rv = search(source, target, false, nullptr, nullptr);
+    if (rv >= 0)
+        traceStates(target, route);
+    return rv;
+}
+
+// the same with the cells and passages closed in overlay avoided
+
+int DijkstraPlanner::shortestPath(int source, int target, std::vector<int> & route, const QueryOverlay & overlay)
+{
+    route.clear();
+    int vCount = this -> graph -> getVertexCount();
+    if (source < 0 || source >= vCount || target < 0 || target >= vCount || overlay.isVertexBlocked(source))
+        return -1;
+    int rv = search(source, target, false, & overlay, nullptr);
+    if (rv >= 0)
+        traceStates(target, route);
+    return rv;
+}
+
+// shortest start -> any coffee station -> goal route
+// returns the route length, or -1 if there is none
+
+int DijkstraPlanner::coffeeRoute(int start, int goal, std::vector<int> & route)
+{
+    route.clear();
+    int vCount = this -> graph -> getVertexCount();
+    if (start < 0 || start >= vCount || goal < 0 || goal >= vCount)
+        return -1;
+    int source = start + (this -> graph -> getVertex(start).getC() ? vCount : 0);
+    int rv = search(source, goal + vCount, true, nullptr, nullptr);
+    if (rv >= 0)
+        traceStates(goal + vCount, route);
+    return rv;
+}
+
+// a closed coffee station cannot serve the route; a closed start cannot begin it
+
+int DijkstraPlanner::coffeeRoute(int start, int goal, std::vector<int> & route, const QueryOverlay & overlay)
+{
+    route.clear();
+    int vCount = this -> graph -> getVertexCount();
+    if (start < 0 || start >= vCount || goal < 0 || goal >= vCount || overlay.isVertexBlocked(start))
+        return -1;
+    int source = start + (this -> graph -> getVertex(start).getC() ? vCount : 0);
+    int rv = search(source, goal + vCount, true, & overlay, nullptr);
+    if (rv >= 0)
+        traceStates(goal + vCount, route);
+    return rv;
+}
+
+// under a deadline or cancellation token; a search cut short returns no route
+
+SearchResult DijkstraPlanner::shortestPath(int source, int target, std::vector<int> & route, SearchLimit & limit)
+{
+    route.clear();
+    int vCount = this -> graph -> getVertexCount();
+    if (source < 0 || source >= vCount || target < 0 || target >= vCount)
+        return limit.finish(-1);
+    int rv = search(source, target, false, nullptr, & limit);
+    if (rv >= 0)
+        traceStates(target, route);
+    return limit.finish(rv);
+}
+
+SearchResult DijkstraPlanner::coffeeRoute(int start, int goal, std::vector<int> & route, SearchLimit & limit)
+{
+    route.clear();
+    int vCount = this -> graph -> getVertexCount();
+    if (start < 0 || start >= vCount || goal < 0 || goal >= vCount)
+        return limit.finish(-1);
+    int source = start + (this -> graph -> getVertex(start).getC() ? vCount : 0);
+    int rv = search(source, goal + vCount, true, nullptr, & limit);
+    if (rv >= 0)
+        traceStates(goal + vCount, route);
+    return limit.finish(rv);
+}
+
+// a stale state is reset when the query first reaches it
+
+void DijkstraPlanner::touch(int state)
+{
+    if (this -> seen[state] != this -> generation)
+    {
+        this -> seen[state] = this -> generation;
+        this -> dist[state] = -1;
+        this -> parent[state] = -1;
+    }
+}
+
+// overlay and limit are nullptr for an unrestricted search; target -1 (distances()
+// only) settles every reachable state and returns 0
+// seen is cleared once per 2^32 searches when the generation wraps
+
+int DijkstraPlanner::search(int source, int target, bool coffee, const QueryOverlay * overlay, SearchLimit * limit)
+{
+    int vCount = this -> graph -> getVertexCount();
+    int states = coffee ? 2 * vCount : vCount;
+    this -> settled = 0;
+    this -> generation++;
+    if (this -> generation == 0)
+    {
+        std::fill(this -> seen.begin(), this -> seen.end(), 0);
+        this -> generation = 1;
+    }
+    if (source < 0 || source >= states)
+        return -1;
+    touch(source);
+
+    this -> queue.setMaxWeight(this -> graph -> getMaxWeight());
+    this -> dist[source] = 0;
+    this -> queue.push(source, 0);
+
+    int u;
+    int key;
+    while (this -> queue.pop(u, key))
+    {
+        if (key != this -> dist[u])
+            continue;
+        if (limit != nullptr && limit -> shouldStop())
+            return -1;
+        this -> settled++;
+        if (u == target)
+            return key;
+
+        int layer = (u >= vCount) ? vCount : 0;
+        int pivot = u - layer;
+        for (int e = this -> graph -> getFirstEdge(pivot); e < this -> graph -> getLastEdge(pivot); e++)
+        {
+            int v = this -> graph -> getTarget(e);
+            if (overlay != nullptr && !overlay -> allows(e, v))
+                continue;
+            int next = v + layer;
+            if (coffee && layer == 0 && this -> graph -> getVertex(v).getC())
+                next = v + vCount;
+            int nd = key + this -> graph -> getWeight(e);
+            touch(next);
+            if (this -> dist[next] < 0 || nd < this -> dist[next])
+            {
+                this -> dist[next] = nd;
+                this -> parent[next] = u;
+                this -> queue.push(next, nd);
+            }
+        }
+    }
+    return (target < 0) ? 0 : -1;
+}
+
+void DijkstraPlanner::traceStates(int target, std::vector<int> & route) const
+{
+    int vCount = this -> graph -> getVertexCount();
+    for (int s = target; s >= 0; s = this -> parent[s])
+        route.push_back(s % vCount);
+    std::reverse(route.begin(), route.end());
+}
+
+void runWeightedSearch()
+{
+    std::cout << "Weighted search will start.";
+
+    // demo floor with a carpet across the right hand corridor
+
+    FloorMap floor = FloorMap::demoFloor();
+    floor.setCell(6, 2, '4');
+    floor.setCell(7, 2, '4');
+    floor.setCell(8, 2, '4');
+    floor.printMap();
+
+    std::vector<Vertex> U;
+    std::vector<Edge> edgeVector;
+    floor.makeEdgesAndVertices(U, edgeVector);
+    FloorGraph graph(U, edgeVector);
+    DijkstraPlanner planner(graph);
+
+    std::vector<int> route;
+    int length = planner.coffeeRoute(graph.findId(3, 2), graph.findId(3, 4), route);
+    std::cout << "\nCoffee route of cost " << length << ":";
+    graph.printRoute(route);
+
+    // weighted Dijkstra against plain BFS on a larger open floor
+
+    const int SIDE = 512;
+    FloorMap big(SIDE, SIDE);
+    for (int y = 0; y < SIDE; y++)
+        for (int x = 0; x < SIDE; x++)
+            if ((x * 7 + y * 13) % 11 == 0)
+                big.setCell(x, y, (char) ('1' + (x + y) % 5));
+    std::vector<Vertex> bigU;
+    std::vector<Edge> bigEdges;
+    big.makeEdgesAndVertices(bigU, bigEdges);
+    FloorGraph bigGraph(bigU, bigEdges);
+    DijkstraPlanner bigPlanner(bigGraph);
+
+    // one warm-up query each, so the timed ones measure the search, not first allocations
+
+    std::vector<int> dist;
+    std::vector<int> parent;
+    bigGraph.bfs(0, dist, parent);
+    bigPlanner.distances(0, dist, parent);
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    bigGraph.bfs(0, dist, parent);
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    bigPlanner.distances(0, dist, parent);
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+    long long bfsMicros = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+    long long dijkstraMicros = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+    std::cout << "\n" << bigGraph.getVertexCount() << " vertices, max edge weight " << bigGraph.getMaxWeight() << ".";
+    std::cout << "\nBFS: " << bfsMicros << " us.";
+    std::cout << "\nDijkstra (bucket queue): " << dijkstraMicros << " us, ";
+    std::cout << (double) dijkstraMicros / std::max(1LL, bfsMicros) << " x BFS.";
+}
+
+#endif /* weightedSearch_h */
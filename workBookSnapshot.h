@@ -0,0 +1,313 @@
+//  workBookSnapshot.h
+//  Coffee Robot Problem
+//  Graph Solution G = (V, E)
+//  Checkpoint and resume of WorkBook searches.
+
+#ifndef workBookSnapshot_h
+#define workBookSnapshot_h
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "floorGraph.h"
+#include "graphSolution.h"
+
+// snapshot file (native byte order)
+//   char[4]   "WBK1"
+//   uint64    FloorGraph::fingerprint of U and edgeVector
+//   uint32    vertex count V
+//   uint32    bytes per vertex id (2 when V < 65536, else 4)
+//   int32     booksCount, pathSizeTarget, start id, goal id
+//   uint8[(V + 7) / 8] ex bitset, then fr bitset
+//   booksCount levels of
+//     uint32  bookSize
+//     bookSize paths of uint32 path size followed by the vertex ids
+// the file is written beside its final name and renamed over it, so a crash
+// while checkpointing leaves the previous snapshot intact
+
+class WorkBookSnapshot
+{
+    public:
+        static bool save(const WorkBook &, const std::string &);
+        static bool resume(WorkBook &, const std::string &);
+        static void addBooks(WorkBook &, int, const std::string &);
+        static SearchResult addBooks(WorkBook &, int, const std::string &, SearchLimit &);
+
+    private:
+        static void putBytes(std::vector<char> &, const void *, size_t);
+        static void putId(std::vector<char> &, uint32_t, uint32_t);
+        static bool getBytes(const char *, size_t, size_t &, void *, size_t);
+        static bool getId(const char *, size_t, size_t &, uint32_t, uint32_t &);
+};
+
+void WorkBookSnapshot::putBytes(std::vector<char> & out, const void * data, size_t length)
+{
+    const char * bytes = (const char *) data;
+    out.insert(out.end(), bytes, bytes + length);
+}
+
+void WorkBookSnapshot::putId(std::vector<char> & out, uint32_t id, uint32_t idBytes)
+{
+    if (idBytes == 2)
+    {
+        uint16_t shortId = (uint16_t) id;
+        putBytes(out, & shortId, sizeof(shortId));
+    }
+    else
+        putBytes(out, & id, sizeof(id));
+}
+
+bool WorkBookSnapshot::getBytes(const char * data, size_t length, size_t & offset, void * target, size_t count)
+{
+    if (offset + count > length)
+        return false;
+    std::memcpy(target, data + offset, count);
+    offset += count;
+    return true;
+}
+
+bool WorkBookSnapshot::getId(const char * data, size_t length, size_t & offset, uint32_t idBytes, uint32_t & id)
+{
+    if (idBytes == 2)
+    {
+        uint16_t shortId = 0;
+        if (!getBytes(data, length, offset, & shortId, sizeof(shortId)))
+            return false;
+        id = shortId;
+        return true;
+    }
+    return getBytes(data, length, offset, & id, sizeof(id));
+}
+
+bool WorkBookSnapshot::save(const WorkBook & wb, const std::string & fileName)
+{
+    FloorGraph graph(wb.U, wb.edgeVector);
+    uint32_t vCount = (uint32_t) graph.getVertexCount();
+    uint32_t idBytes = (vCount < 65536) ? 2 : 4;
+    uint64_t print = graph.fingerprint();
+    int32_t header [4] = { wb.booksCount, wb.pathSizeTarget, graph.findId(wb.start), graph.findId(wb.goal) };
+
+    std::vector<char> out;
+    putBytes(out, "WBK1", 4);
+    putBytes(out, & print, sizeof(print));
+    putBytes(out, & vCount, sizeof(vCount));
+    putBytes(out, & idBytes, sizeof(idBytes));
+    putBytes(out, header, sizeof(header));
+
+    std::vector<unsigned char> ex((vCount + 7) / 8, 0);
+    std::vector<unsigned char> fr((vCount + 7) / 8, 0);
+    for (size_t i = 0; i < wb.ex.size(); i++)
+    {
+        int id = graph.findId(wb.ex[i]);
+        if (id >= 0)
+            ex[id / 8] |= (unsigned char) (1 << (id % 8));
+    }
+    for (size_t i = 0; i < wb.fr.size(); i++)
+    {
+        int id = graph.findId(wb.fr[i]);
+        if (id >= 0)
+            fr[id / 8] |= (unsigned char) (1 << (id % 8));
+    }
+    putBytes(out, ex.data(), ex.size());
+    putBytes(out, fr.data(), fr.size());
+
+    for (int b = 0; b < wb.booksCount; b++)
+    {
+        const PathBook & book = *(wb.books + b);
+        uint32_t bookSize = (uint32_t) std::max(0, book.getBookSize());
+        putBytes(out, & bookSize, sizeof(bookSize));
+        for (uint32_t p = 0; p < bookSize; p++)
+        {
+            const Path & path = *(book.getBookPtr() + p);
+            uint32_t pathSize = (uint32_t) std::max(0, path.getPathSize());
+            putBytes(out, & pathSize, sizeof(pathSize));
+            for (uint32_t k = 0; k < pathSize; k++)
+                putId(out, (uint32_t) graph.findId(*(path.getPathPtr() + k)), idBytes);
+        }
+    }
+
+    std::string temporary = fileName + ".tmp";
+    FILE * file = std::fopen(temporary.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+    bool ok = std::fwrite(out.data(), 1, out.size(), file) == out.size();
+    ok = (std::fflush(file) == 0) && ok;
+    ok = (fsync(fileno(file)) == 0) && ok;
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok || std::rename(temporary.c_str(), fileName.c_str()) != 0)
+    {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+// wb must already hold the same map (e.g. from the 6 arg constructor)
+// the snapshot is memory-mapped and decoded in place; returns false and leaves wb
+// untouched if the file is missing, damaged or was taken on another map
+
+bool WorkBookSnapshot::resume(WorkBook & wb, const std::string & fileName)
+{
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, & info) != 0 || info.st_size < 4)
+    {
+        close(fd);
+        return false;
+    }
+    size_t length = (size_t) info.st_size;
+    void * mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+    const char * data = (const char *) mapping;
+
+    FloorGraph graph(wb.U, wb.edgeVector);
+    size_t offset = 4;
+    uint64_t print = 0;
+    uint32_t vCount = 0;
+    uint32_t idBytes = 0;
+    int32_t header [4];
+    bool ok = std::memcmp(data, "WBK1", 4) == 0 &&
+              getBytes(data, length, offset, & print, sizeof(print)) &&
+              getBytes(data, length, offset, & vCount, sizeof(vCount)) &&
+              getBytes(data, length, offset, & idBytes, sizeof(idBytes)) &&
+              getBytes(data, length, offset, header, sizeof(header));
+    ok = ok && print == graph.fingerprint() && vCount == (uint32_t) graph.getVertexCount() &&
+         (idBytes == 2 || idBytes == 4) && header[0] >= 1 && header[0] < wb.booksBuffer &&
+         header[2] >= 0 && header[3] >= 0 && header[2] < (int32_t) vCount && header[3] < (int32_t) vCount;
+
+    size_t bitsetBytes = (vCount + 7) / 8;
+    const unsigned char * ex = (const unsigned char *) (data + offset);
+    const unsigned char * fr = ex + bitsetBytes;
+    ok = ok && offset + 2 * bitsetBytes <= length;
+    offset += 2 * bitsetBytes;
+
+    // decode every level before touching wb
+
+    std::vector<std::vector<Path>> levels;
+    std::vector<Vertex> vertices;
+    uint32_t longest = 0;
+    for (int b = 0; ok && b < header[0]; b++)
+    {
+        uint32_t bookSize = 0;
+        ok = getBytes(data, length, offset, & bookSize, sizeof(bookSize));
+        levels.push_back(std::vector<Path>());
+        for (uint32_t p = 0; ok && p < bookSize; p++)
+        {
+            uint32_t pathSize = 0;
+            ok = getBytes(data, length, offset, & pathSize, sizeof(pathSize)) && pathSize <= vCount;
+            longest = std::max(longest, pathSize);
+            vertices.clear();
+            for (uint32_t k = 0; ok && k < pathSize; k++)
+            {
+                uint32_t id = 0;
+                ok = getId(data, length, offset, idBytes, id) && id < vCount;
+                if (ok)
+                    vertices.push_back(graph.getVertex((int) id));
+            }
+            if (ok)
+                levels.back().push_back(Path(vertices.data(), (int) vertices.size()));
+        }
+    }
+
+    // the next level's target size follows from the paths already built
+
+    ok = ok && header[1] >= 2 && (uint32_t) header[1] >= longest && (uint32_t) header[1] <= vCount + 1;
+
+    if (ok)
+    {
+        wb.booksCount = header[0];
+        wb.pathSizeTarget = header[1];
+        wb.start = graph.getVertex(header[2]);
+        wb.goal = graph.getVertex(header[3]);
+        wb.ex.clear();
+        wb.fr.clear();
+        for (uint32_t id = 0; id < vCount; id++)
+        {
+            if (ex[id / 8] & (1 << (id % 8)))
+                wb.ex.push_back(graph.getVertex((int) id));
+            if (fr[id / 8] & (1 << (id % 8)))
+                wb.fr.push_back(graph.getVertex((int) id));
+        }
+
+        for (int b = 0; b < wb.booksCount; b++)
+        {
+            PathBook & book = *(wb.books + b);
+            delete [] book.book;
+            book.start = wb.start;
+            book.bookCapacity = std::max(10, 2 * (int) levels[b].size());
+            book.book = new Path [book.bookCapacity];
+            book.bookSize = (int) levels[b].size();
+            for (size_t p = 0; p < levels[b].size(); p++)
+                *(book.book + p) = levels[b][p];
+        }
+    }
+
+    munmap(mapping, length);
+    return ok;
+}
+
+// WorkBook::addBooks with a snapshot after every completed level
+
+void WorkBookSnapshot::addBooks(WorkBook & wb, int n, const std::string & fileName)
+{
+    SearchLimit none;
+    addBooks(wb, n, fileName, none);
+}
+
+SearchResult WorkBookSnapshot::addBooks(WorkBook & wb, int n, const std::string & fileName, SearchLimit & limit)
+{
+    return wb.addBooks(n, limit, [&fileName](WorkBook & level)
+    {
+        if (!save(level, fileName))
+            std::cout << "\nSnapshot " << fileName << " could not be written.";
+    });
+}
+
+// interrupt a search after three levels, then resume it in a fresh WorkBook
+
+void runWorkBookSnapshot()
+{
+    std::cout << "Snapshot testing will start.";
+    const int DELAY = 2;
+    std::string fileName = "/tmp/coffeeRobot-" + std::to_string(getpid()) + ".wbk";
+
+    std::vector<Vertex> U;
+    std::vector<Vertex> n;
+    std::vector<Vertex> ex;
+    std::vector<Vertex> fr;
+    std::vector<Edge> edgeVector;
+    WorkBook first ( 2, U, n, ex, fr, edgeVector );
+    for (int level = 0; level < 3; level++)
+    {
+        first.calibrate(DELAY);
+        first.addBook();
+    }
+    WorkBookSnapshot::save(first, fileName);
+
+    std::vector<Vertex> U2;
+    std::vector<Vertex> n2;
+    std::vector<Vertex> ex2;
+    std::vector<Vertex> fr2;
+    std::vector<Edge> edgeVector2;
+    WorkBook second ( 2, U2, n2, ex2, fr2, edgeVector2 );
+    if (!WorkBookSnapshot::resume(second, fileName))
+    {
+        std::cout << "\nSnapshot " << fileName << " could not be resumed.";
+        return;
+    }
+    std::cout << "\nResumed at booksCount " << second.booksCount << ", path size target " << second.getPathSizeTarget() << ".";
+    WorkBookSnapshot::addBooks(second, DELAY, fileName);
+    second.printSolution();
+    std::remove(fileName.c_str());
+}
+
+#endif /* workBookSnapshot_h */